@@ -0,0 +1,569 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <tbb/tbb.h>
+#include "ParallelSort.h"
+#include "RadixSort.h"
+
+//外部排序：数据比内存大时，文件 -> 有序的run文件 -> 多路归并 -> 输出文件
+//文件就是T的原始二进制数组，T需要是可平凡拷贝的类型
+namespace ExternalSort {
+
+    //默认内存预算
+    const std::size_t DEFAULT_MEMORY_BYTES = std::size_t(256) << 20;
+    //每次读写的块大小上下限，顺序大块I/O
+    const std::size_t MIN_IO_BYTES = std::size_t(64) << 10;
+    const std::size_t MAX_IO_BYTES = std::size_t(8) << 20;
+    //每个归并分段至少这么多元素
+    const std::uint64_t MIN_PART_ELEMS = std::uint64_t(1) << 20;
+    //归并时同时打开的run文件数上限（所有并行的分段加起来），常见的ulimit -n是1024
+    const std::size_t MAX_OPEN_FILES = 512;
+
+    struct Stats {
+        std::size_t num_runs = 0;
+        std::size_t merge_passes = 0;
+        std::uint64_t num_elems = 0;
+        double run_seconds = 0;     //生成run的时间
+        double merge_seconds = 0;   //多路归并的时间
+    };
+
+    //整数用基数排序，其他类型用并行快速排序
+    template <typename T>
+    void sortRun(std::vector<T> &run) {
+        if constexpr (std::is_integral_v<T>) {
+            RadixSort::lsdSort(run.data(), run.data() + run.size());
+        } else {
+            ParallelSort::quickSort(run.begin(), run.end());
+        }
+    }
+
+    //随机读run文件中的第idx个元素，用于抽样和二分查找分界点
+    template <typename T>
+    T readAt(std::ifstream &file, std::uint64_t idx) {
+        T v;
+        file.seekg(idx * sizeof(T));
+        file.read((char *) &v, sizeof(T));
+        return v;
+    }
+
+    //在有序run文件[0, n)中二分查找第一个不小于v的位置
+    template <typename T>
+    std::uint64_t lowerBound(std::ifstream &file, std::uint64_t n, const T &v) {
+        std::uint64_t lo = 0, hi = n;
+        while (lo < hi) {
+            std::uint64_t mid = lo + (hi - lo) / 2;
+            if (readAt<T>(file, mid) < v) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    //一次I/O请求的状态，由IoThread的锁保护；同一个请求完成之前不能再提交
+    struct IoRequest {
+        bool done = true;
+        bool result = true;
+    };
+
+    //专用的I/O线程，阻塞I/O不占用TBB的工作线程
+    //一个归并分段的所有读者和写者共用一个线程，任务按提交顺序执行
+    class IoThread {
+    public:
+        IoThread() : myThread([this] { run(); }) {}
+
+        ~IoThread() {
+            {
+                std::lock_guard<std::mutex> lock(myMutex);
+                myStop = true;
+            }
+            myCv.notify_all();
+            myThread.join();
+        }
+
+        IoThread(const IoThread &) = delete;
+        IoThread &operator=(const IoThread &) = delete;
+
+        void submit(IoRequest &request, std::function<bool()> job) {
+            {
+                std::lock_guard<std::mutex> lock(myMutex);
+                request.done = false;
+                myJobs.emplace_back(&request, std::move(job));
+            }
+            myCv.notify_all();
+        }
+
+        //等request完成，返回它的结果（I/O是否成功）
+        bool wait(IoRequest &request) {
+            std::unique_lock<std::mutex> lock(myMutex);
+            myCv.wait(lock, [&request] { return request.done; });
+            return request.result;
+        }
+
+    private:
+        void run() {
+            std::unique_lock<std::mutex> lock(myMutex);
+            while (true) {
+                myCv.wait(lock, [this] { return myStop || !myJobs.empty(); });
+                //析构前提交的任务也要做完
+                if (myJobs.empty()) {
+                    return;
+                }
+                auto job = std::move(myJobs.front());
+                myJobs.pop_front();
+                lock.unlock();
+                const bool result = job.second();
+                lock.lock();
+                job.first->result = result;
+                job.first->done = true;
+                myCv.notify_all();
+            }
+        }
+
+        std::mutex myMutex;
+        std::condition_variable myCv;
+        std::deque<std::pair<IoRequest *, std::function<bool()>>> myJobs;
+        bool myStop = false;
+        //最后初始化，线程启动时其他成员已经构造好
+        std::thread myThread;
+    };
+
+    //顺序读取run文件的一段[begin, end)，双缓冲：
+    //消费当前块的同时，I/O线程io预读下一块；io要比读者活得长
+    //读不满一块（文件被截断、读错误）时failed()为true，empty()也为true，归并随之结束
+    template <typename T>
+    class RunReader {
+    public:
+        RunReader(IoThread &io, const std::string &path, std::uint64_t begin, std::uint64_t end,
+                  std::size_t block_elems)
+                : myIo(io), myFile(path, std::ios::binary), myNext(begin), myEnd(end), myBlockElems(block_elems) {
+            myFile.seekg(begin * sizeof(T));
+            if (!myFile) {
+                myFailed = true;
+                return;
+            }
+            prefetch();
+            advance();
+        }
+
+        //等预读完成后才能释放缓冲区和文件
+        ~RunReader() {
+            if (myPending) {
+                myIo.wait(myRequest);
+            }
+        }
+
+        RunReader(const RunReader &) = delete;
+        RunReader &operator=(const RunReader &) = delete;
+
+        bool empty() const { return myPos == myCurrent.size(); }
+        bool failed() const { return myFailed; }
+        const T &front() const { return myCurrent[myPos]; }
+
+        void pop() {
+            if (++myPos == myCurrent.size()) {
+                advance();
+            }
+        }
+
+    private:
+        void prefetch() {
+            if (myNext == myEnd) {
+                return;
+            }
+            const std::size_t count = (std::size_t) std::min<std::uint64_t>(myBlockElems, myEnd - myNext);
+            myNext += count;
+            myPending = true;
+            myIo.submit(myRequest, [this, count]() {
+                myLoading.resize(count);
+                myFile.read((char *) myLoading.data(), count * sizeof(T));
+                return myFile.gcount() == (std::streamsize) (count * sizeof(T));
+            });
+        }
+
+        void advance() {
+            myPos = 0;
+            myCurrent.clear();
+            if (!myPending) {
+                return;
+            }
+            myPending = false;
+            if (!myIo.wait(myRequest)) {
+                myFailed = true;
+                return;
+            }
+            myCurrent.swap(myLoading);
+            prefetch();
+        }
+
+        IoThread &myIo;
+        IoRequest myRequest;
+        std::ifstream myFile;
+        std::uint64_t myNext;
+        std::uint64_t myEnd;
+        std::size_t myBlockElems;
+        std::vector<T> myCurrent;
+        std::vector<T> myLoading;
+        std::size_t myPos = 0;
+        bool myPending = false;
+        bool myFailed = false;
+    };
+
+    //从offset开始顺序写输出文件，双缓冲：填满一块后交给I/O线程io写，继续填另一块；io要比写者活得长
+    //close()写完剩下的数据，返回所有块是否都写成功
+    template <typename T>
+    class RunWriter {
+    public:
+        RunWriter(IoThread &io, const std::string &path, std::uint64_t offset, std::size_t block_elems)
+                : myIo(io), myFile(path, std::ios::binary | std::ios::in | std::ios::out), myBlockElems(block_elems) {
+            myFile.seekp(offset * sizeof(T));
+            myOk = (bool) myFile;
+            myBuffer.reserve(block_elems);
+        }
+
+        ~RunWriter() { close(); }
+
+        RunWriter(const RunWriter &) = delete;
+        RunWriter &operator=(const RunWriter &) = delete;
+
+        void push(const T &v) {
+            myBuffer.push_back(v);
+            if (myBuffer.size() == myBlockElems) {
+                flush();
+            }
+        }
+
+        bool close() {
+            flush();
+            waitPending();
+            return myOk;
+        }
+
+    private:
+        void waitPending() {
+            if (myPending) {
+                myPending = false;
+                myOk = myIo.wait(myRequest) && myOk;
+            }
+        }
+
+        void flush() {
+            waitPending();
+            if (myBuffer.empty() || !myOk) {
+                myBuffer.clear();
+                return;
+            }
+            myWriting.swap(myBuffer);
+            myBuffer.clear();
+            myPending = true;
+            myIo.submit(myRequest, [this]() {
+                myFile.write((const char *) myWriting.data(), myWriting.size() * sizeof(T));
+                return (bool) myFile;
+            });
+        }
+
+        IoThread &myIo;
+        IoRequest myRequest;
+        std::fstream myFile;
+        std::size_t myBlockElems;
+        std::vector<T> myBuffer;
+        std::vector<T> myWriting;
+        bool myPending = false;
+        bool myOk = true;
+    };
+
+    //第一阶段：parallel_pipeline读入内存大小的run -> 并行排序 -> 写run文件
+    //两个token：一个run在排序时，下一个run在读入，上一个run在写出
+    template <typename T>
+    bool makeRuns(const std::string &input, const std::string &temp_prefix, std::size_t memory_bytes,
+                  std::vector<std::string> &run_paths, std::vector<std::uint64_t> &run_sizes) {
+        std::ifstream in(input, std::ios::binary);
+        if (!in) {
+            std::cerr << "Error: cannot open " << input << std::endl;
+            return false;
+        }
+        //两个token，每个run排序时还需要一份同样大的临时空间
+        const std::size_t run_elems = std::max<std::size_t>(1, memory_bytes / sizeof(T) / 4);
+        using RunPtr = std::shared_ptr<std::vector<T>>;
+        bool ok = true;
+        tbb::parallel_pipeline(
+                2,
+                tbb::make_filter<void, RunPtr>(
+                        tbb::filter_mode::serial_in_order,
+                        [&](tbb::flow_control &fc) -> RunPtr {
+                            auto run = std::make_shared<std::vector<T>>(run_elems);
+                            in.read((char *) run->data(), run_elems * sizeof(T));
+                            std::size_t got = in.gcount() / sizeof(T);
+                            if (in.bad()) {
+                                std::cerr << "Error: cannot read " << input << std::endl;
+                                ok = false;
+                            }
+                            if (got == 0 || !ok) {
+                                fc.stop();
+                                return {};
+                            }
+                            run->resize(got);
+                            return run;
+                        }) &
+                tbb::make_filter<RunPtr, RunPtr>(
+                        tbb::filter_mode::parallel,
+                        [](RunPtr run) -> RunPtr {
+                            sortRun(*run);
+                            return run;
+                        }) &
+                tbb::make_filter<RunPtr, void>(
+                        tbb::filter_mode::serial_in_order,
+                        [&](RunPtr run) {
+                            std::string path = temp_prefix + ".run" + std::to_string(run_paths.size());
+                            std::ofstream out(path, std::ios::binary);
+                            out.write((const char *) run->data(), run->size() * sizeof(T));
+                            if (!out) {
+                                std::cerr << "Error: cannot write " << path << std::endl;
+                                ok = false;
+                            }
+                            run_paths.push_back(path);
+                            run_sizes.push_back(run->size());
+                        })
+        );
+        return ok;
+    }
+
+    //一次归并最多读多少个run：concurrency个并行分段的读写缓冲区（每个至少MIN_IO_BYTES，双缓冲）不超过内存预算，
+    //打开的文件不超过MAX_OPEN_FILES；每段还有一个写者，所以减1
+    inline std::size_t maxFanIn(std::size_t memory_bytes, std::size_t concurrency) {
+        const std::size_t by_memory = memory_bytes / (2 * MIN_IO_BYTES * concurrency);
+        const std::size_t by_files = MAX_OPEN_FILES / concurrency;
+        return std::max<std::size_t>(3, std::min(by_memory, by_files)) - 1;
+    }
+
+    //第二阶段：并行多路归并，run的个数不超过maxFanIn
+    //从各run抽样选出分割值，把值域切成若干段，每段在每个run中的范围用二分查找确定，
+    //各段在输出文件中的偏移也随之确定，于是各段可以独立并行地做多路归并
+    template <typename T>
+    bool mergeRuns(const std::vector<std::string> &run_paths, const std::vector<std::uint64_t> &run_sizes,
+                   const std::string &output, std::size_t memory_bytes) {
+        const std::size_t k = run_paths.size();
+        std::uint64_t total = 0;
+        for (std::uint64_t s : run_sizes) {
+            total += s;
+        }
+        {
+            std::ofstream out(output, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                std::cerr << "Error: cannot create " << output << std::endl;
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::resize_file(output, total * sizeof(T), ec);
+        if (ec) {
+            std::cerr << "Error: cannot resize " << output << ": " << ec.message() << std::endl;
+            return false;
+        }
+
+        const std::size_t concurrency = tbb::this_task_arena::max_concurrency();
+        const std::size_t num_parts = (std::size_t) std::max<std::uint64_t>(
+                1, std::min<std::uint64_t>(4 * concurrency, total / MIN_PART_ELEMS));
+
+        //每个run抽样，选出num_parts-1个分割值
+        std::vector<std::ifstream> files;
+        for (const auto &path : run_paths) {
+            files.emplace_back(path, std::ios::binary);
+        }
+        std::vector<T> samples;
+        const std::size_t samples_per_run = 8 * num_parts;
+        for (std::size_t r = 0; r < k; ++r) {
+            for (std::size_t s = 0; s < samples_per_run && run_sizes[r] > 0; ++s) {
+                samples.push_back(readAt<T>(files[r], run_sizes[r] * s / samples_per_run));
+            }
+        }
+        std::sort(samples.begin(), samples.end());
+
+        //bounds[r * (num_parts + 1) + p]：第p段在run r中的起点
+        std::vector<std::uint64_t> bounds(k * (num_parts + 1));
+        tbb::parallel_for(std::size_t(0), k, [&](std::size_t r) {
+            bounds[r * (num_parts + 1)] = 0;
+            for (std::size_t p = 1; p < num_parts; ++p) {
+                const T &splitter = samples[p * samples.size() / num_parts];
+                bounds[r * (num_parts + 1) + p] = lowerBound(files[r], run_sizes[r], splitter);
+            }
+            bounds[r * (num_parts + 1) + num_parts] = run_sizes[r];
+        });
+        for (std::size_t r = 0; r < k; ++r) {
+            if (!files[r]) {
+                std::cerr << "Error: cannot read " << run_paths[r] << std::endl;
+                return false;
+            }
+        }
+        files.clear();
+
+        std::vector<std::uint64_t> part_offset(num_parts + 1, 0);
+        for (std::size_t p = 0; p < num_parts; ++p) {
+            part_offset[p + 1] = part_offset[p];
+            for (std::size_t r = 0; r < k; ++r) {
+                part_offset[p + 1] += bounds[r * (num_parts + 1) + p + 1] - bounds[r * (num_parts + 1) + p];
+            }
+        }
+
+        //同时活跃的归并数 * (k个读者 + 1个写者) * 双缓冲
+        const std::size_t io_bytes = std::clamp(memory_bytes / (std::min(concurrency, num_parts) * (k + 1) * 2),
+                                                MIN_IO_BYTES, MAX_IO_BYTES);
+        const std::size_t block_elems = std::max<std::size_t>(1, io_bytes / sizeof(T));
+
+        //任何一段读写失败都让整个归并失败，其他段看到后尽早停止
+        std::atomic<bool> ok{true};
+        tbb::parallel_for(std::size_t(0), num_parts, [&](std::size_t p) {
+            //先构造、最后析构：读者和写者析构时还要等自己的I/O请求
+            IoThread io;
+            using Head = std::pair<T, std::size_t>;
+            auto greater = [](const Head &a, const Head &b) { return b.first < a.first; };
+            std::priority_queue<Head, std::vector<Head>, decltype(greater)> heap(greater);
+            std::vector<std::unique_ptr<RunReader<T>>> readers(k);
+            for (std::size_t r = 0; r < k; ++r) {
+                std::uint64_t begin = bounds[r * (num_parts + 1) + p];
+                std::uint64_t end = bounds[r * (num_parts + 1) + p + 1];
+                if (begin < end) {
+                    readers[r] = std::make_unique<RunReader<T>>(io, run_paths[r], begin, end, block_elems);
+                    if (readers[r]->failed()) {
+                        std::cerr << "Error: cannot read " << run_paths[r] << std::endl;
+                        ok = false;
+                        return;
+                    }
+                    heap.emplace(readers[r]->front(), r);
+                }
+            }
+            RunWriter<T> writer(io, output, part_offset[p], block_elems);
+            while (!heap.empty() && ok.load(std::memory_order_relaxed)) {
+                std::size_t r = heap.top().second;
+                writer.push(heap.top().first);
+                heap.pop();
+                readers[r]->pop();
+                if (!readers[r]->empty()) {
+                    heap.emplace(readers[r]->front(), r);
+                } else if (readers[r]->failed()) {
+                    std::cerr << "Error: cannot read " << run_paths[r] << std::endl;
+                    ok = false;
+                }
+            }
+            if (!writer.close()) {
+                std::cerr << "Error: cannot write " << output << std::endl;
+                ok = false;
+            }
+        });
+        return ok;
+    }
+
+    //run比fan_in多时分多趟归并：每趟把相邻的fan_in个run归并成一个新的run文件，成功后删除输入的run，
+    //run_paths、run_sizes随之更新；失败时它们是剩下的全部run文件（数据唯一完整的副本）
+    template <typename T>
+    bool reduceRuns(const std::string &temp_prefix, std::size_t memory_bytes, std::size_t fan_in,
+                    std::vector<std::string> &run_paths, std::vector<std::uint64_t> &run_sizes,
+                    std::size_t *passes) {
+        std::size_t next_id = run_paths.size();
+        while (run_paths.size() > fan_in) {
+            std::vector<std::string> paths;
+            std::vector<std::uint64_t> sizes;
+            for (std::size_t g = 0; g < run_paths.size(); g += fan_in) {
+                const std::size_t g_end = std::min(run_paths.size(), g + fan_in);
+                if (g_end - g == 1) {
+                    paths.push_back(run_paths[g]);
+                    sizes.push_back(run_sizes[g]);
+                    continue;
+                }
+                const std::vector<std::string> group_paths(run_paths.begin() + g, run_paths.begin() + g_end);
+                const std::vector<std::uint64_t> group_sizes(run_sizes.begin() + g, run_sizes.begin() + g_end);
+                const std::string path = temp_prefix + ".run" + std::to_string(next_id++);
+                if (!mergeRuns<T>(group_paths, group_sizes, path, memory_bytes)) {
+                    std::filesystem::remove(path);
+                    paths.insert(paths.end(), run_paths.begin() + g, run_paths.end());
+                    sizes.insert(sizes.end(), run_sizes.begin() + g, run_sizes.end());
+                    run_paths.swap(paths);
+                    run_sizes.swap(sizes);
+                    return false;
+                }
+                for (const auto &p : group_paths) {
+                    std::filesystem::remove(p);
+                }
+                std::uint64_t merged = 0;
+                for (std::uint64_t size : group_sizes) {
+                    merged += size;
+                }
+                paths.push_back(path);
+                sizes.push_back(merged);
+            }
+            run_paths.swap(paths);
+            run_sizes.swap(sizes);
+            ++*passes;
+        }
+        return true;
+    }
+
+    //对二进制文件input排序，结果写到output
+    //memory_bytes是内存预算，run文件以output为前缀临时存放，结束后删除；run太多时先分趟归并（reduceRuns）；
+    //归并失败时保留run文件（此时它们是数据唯一完整的副本），output的内容不可用
+    template <typename T>
+    bool sortFile(const std::string &input, const std::string &output,
+                  std::size_t memory_bytes = DEFAULT_MEMORY_BYTES, Stats *stats = nullptr) {
+        static_assert(std::is_trivially_copyable_v<T>, "external sort works on raw binary records");
+        std::vector<std::string> run_paths;
+        std::vector<std::uint64_t> run_sizes;
+
+        tbb::tick_count t0 = tbb::tick_count::now();
+        bool ok = makeRuns<T>(input, output, memory_bytes, run_paths, run_sizes);
+        bool merge_failed = false;
+        tbb::tick_count t1 = tbb::tick_count::now();
+        std::size_t num_runs = run_sizes.size(), passes = 0;
+        std::uint64_t num_elems = 0;
+        for (std::uint64_t s : run_sizes) {
+            num_elems += s;
+        }
+        if (ok) {
+            const std::size_t fan_in = maxFanIn(memory_bytes, tbb::this_task_arena::max_concurrency());
+            ok = reduceRuns<T>(output, memory_bytes, fan_in, run_paths, run_sizes, &passes);
+            if (ok && run_paths.size() == 1) {
+                std::filesystem::rename(run_paths[0], output);
+                run_paths.clear();
+            } else if (ok) {
+                ok = mergeRuns<T>(run_paths, run_sizes, output, memory_bytes);
+                ++passes;
+            }
+            merge_failed = !ok;
+        }
+        tbb::tick_count t2 = tbb::tick_count::now();
+        //生成run失败时输入文件还在，run文件没有用
+        if (!merge_failed) {
+            for (const auto &path : run_paths) {
+                std::filesystem::remove(path);
+            }
+        } else if (!run_paths.empty()) {
+            std::cerr << "Error: sort failed, keeping " << run_paths.size() << " run files " << output << ".run*"
+                      << std::endl;
+        }
+
+        if (stats) {
+            stats->num_runs = num_runs;
+            stats->merge_passes = passes;
+            stats->num_elems = num_elems;
+            stats->run_seconds = (t1 - t0).seconds();
+            stats->merge_seconds = (t2 - t1).seconds();
+        }
+        return ok;
+    }
+
+}
@@ -0,0 +1,512 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <tbb/tbb.h>
+
+namespace ParallelSort {
+
+    //小于该长度的区间直接插入排序
+    const std::ptrdiff_t INSERTION_THRESHOLD = 32;
+    //大于该长度的区间用九数取中选基准
+    const std::ptrdiff_t NINTHER_THRESHOLD = 128;
+    //小于该长度的区间不再并行（串行排序/串行归并）
+    const std::ptrdiff_t DEFAULT_GRAIN_SIZE = 1 << 14;
+
+    //插入排序，[first, last)
+    template <typename It, typename Compare>
+    void insertionSort(It first, It last, Compare comp) {
+        if (first == last) {
+            return;
+        }
+        for (It i = first + 1; i != last; ++i) {
+            auto v = std::move(*i);
+            if (comp(v, *first)) {
+                //比第一个还小，整体后移
+                std::move_backward(first, i, i + 1);
+                *first = std::move(v);
+            } else {
+                //*first是哨兵，不会越界
+                It j = i;
+                while (comp(v, *(j - 1))) {
+                    *j = std::move(*(j - 1));
+                    --j;
+                }
+                *j = std::move(v);
+            }
+        }
+    }
+
+    //三数取中，返回中位数所在的迭代器
+    template <typename It, typename Compare>
+    It medianOfThree(It a, It b, It c, Compare comp) {
+        if (comp(*a, *b)) {
+            if (comp(*b, *c)) return b;
+            return comp(*a, *c) ? c : a;
+        }
+        if (comp(*a, *c)) return a;
+        return comp(*b, *c) ? c : b;
+    }
+
+    //九数取中（Tukey's ninther），三组三数取中再取中
+    template <typename It, typename Compare>
+    It ninther(It first, It last, Compare comp) {
+        const std::ptrdiff_t n = last - first;
+        const std::ptrdiff_t s = n / 8;
+        It mid = first + n / 2;
+        It back = last - 1;
+        return medianOfThree(medianOfThree(first, first + s, first + 2 * s, comp),
+                             medianOfThree(mid - s, mid, mid + s, comp),
+                             medianOfThree(back - 2 * s, back - s, back, comp),
+                             comp);
+    }
+
+    //按区间长度选择基准
+    template <typename It, typename Compare>
+    It choosePivot(It first, It last, Compare comp) {
+        const std::ptrdiff_t n = last - first;
+        if (n >= NINTHER_THRESHOLD) {
+            return ninther(first, last, comp);
+        }
+        return medianOfThree(first, first + n / 2, last - 1, comp);
+    }
+
+    //以*first为基准的Hoare划分，返回基准最终位置
+    //[first, p) <= pivot, *p == pivot, (p, last) >= pivot
+    //两边遇到相等元素都会停下，大量重复值时划分仍然均衡
+    template <typename It, typename Compare>
+    It partitionAtFirst(It first, It last, Compare comp) {
+        It i = first + 1, j = last - 1;
+        while (true) {
+            while (i <= j && comp(*i, *first)) ++i;
+            while (comp(*first, *j)) --j;     //*first本身就是哨兵
+            if (i >= j) break;
+            std::iter_swap(i, j);
+            ++i;
+            --j;
+        }
+        std::iter_swap(first, j);
+        return j;
+    }
+
+    //串行introsort：快排 + 深度过深时堆排序 + 小区间插入排序
+    template <typename It, typename Compare>
+    void introSort(It first, It last, Compare comp, int depth_limit) {
+        while (last - first > INSERTION_THRESHOLD) {
+            if (depth_limit == 0) {
+                std::make_heap(first, last, comp);
+                std::sort_heap(first, last, comp);
+                return;
+            }
+            --depth_limit;
+            std::iter_swap(first, choosePivot(first, last, comp));
+            It p = partitionAtFirst(first, last, comp);
+            //递归较短的一边，循环较长的一边，栈深度O(logN)
+            if (p - first < last - p) {
+                introSort(first, p, comp, depth_limit);
+                first = p + 1;
+            } else {
+                introSort(p + 1, last, comp, depth_limit);
+                last = p;
+            }
+        }
+        insertionSort(first, last, comp);
+    }
+
+    //2*floor(log2(n))，和std::sort一样的深度上限
+    inline int depthLimit(std::ptrdiff_t n) {
+        int depth = 0;
+        while (n > 1) {
+            n >>= 1;
+            ++depth;
+        }
+        return 2 * depth;
+    }
+
+    template <typename It, typename Compare>
+    void serialSort(It first, It last, Compare comp) {
+        introSort(first, last, comp, depthLimit(last - first));
+    }
+
+    //并行归并：把[xs, xe)和[ys, ye)两个有序区间移动合并到zs
+    //较长的一边取中点，另一边二分查找对应位置，两半并行，保持稳定性
+    template <typename It1, typename It2, typename Out, typename Compare>
+    void parallelMerge(It1 xs, It1 xe, It2 ys, It2 ye, Out zs, Compare comp, std::ptrdiff_t grain) {
+        const std::ptrdiff_t nx = xe - xs, ny = ye - ys;
+        if (nx + ny <= grain) {
+            std::merge(std::make_move_iterator(xs), std::make_move_iterator(xe),
+                       std::make_move_iterator(ys), std::make_move_iterator(ye), zs, comp);
+            return;
+        }
+        It1 xm;
+        It2 ym;
+        if (nx >= ny) {
+            xm = xs + nx / 2;
+            ym = std::lower_bound(ys, ye, *xm, comp);
+        } else {
+            ym = ys + ny / 2;
+            xm = std::upper_bound(xs, xe, *ym, comp);
+        }
+        Out zm = zs + (xm - xs) + (ym - ys);
+        tbb::parallel_invoke(
+                [=]() { parallelMerge(xs, xm, ys, ym, zs, comp, grain); },
+                [=]() { parallelMerge(xm, xe, ym, ye, zm, comp, grain); }
+        );
+    }
+
+    //乒乓归并：in_place为true时结果留在[xs, xe)，否则移动到zs开始的缓冲区
+    //两个子问题的结果放在另一块内存中，这样每层只搬一次数据
+    template <typename It, typename Buf, typename Compare>
+    void mergeSortImpl(It xs, It xe, Buf zs, Compare comp, std::ptrdiff_t grain, bool in_place) {
+        const std::ptrdiff_t n = xe - xs;
+        if (n <= grain) {
+            serialSort(xs, xe, comp);
+            if (!in_place) {
+                std::move(xs, xe, zs);
+            }
+            return;
+        }
+        It xm = xs + n / 2;
+        Buf zm = zs + n / 2;
+        Buf ze = zs + n;
+        tbb::parallel_invoke(
+                [=]() { mergeSortImpl(xs, xm, zs, comp, grain, !in_place); },
+                [=]() { mergeSortImpl(xm, xe, zm, comp, grain, !in_place); }
+        );
+        if (in_place) {
+            parallelMerge(zs, zm, zm, ze, xs, comp, grain);
+        } else {
+            parallelMerge(xs, xm, xm, xe, zs, comp, grain);
+        }
+    }
+
+    //并行归并排序，叶子是串行introsort，grain以下不再分裂
+    //注意：叶子的introsort不稳定，所以整体也不保证稳定
+    template <typename It, typename Compare>
+    void mergeSort(It first, It last, Compare comp, std::ptrdiff_t grain = DEFAULT_GRAIN_SIZE) {
+        using T = typename std::iterator_traits<It>::value_type;
+        const std::ptrdiff_t n = last - first;
+        if (grain < 2) {
+            grain = 2;
+        }
+        if (n <= grain) {
+            serialSort(first, last, comp);
+            return;
+        }
+        std::vector<T> buffer(n);
+        mergeSortImpl(first, last, buffer.begin(), comp, grain, true);
+    }
+
+    template <typename It>
+    void mergeSort(It first, It last) {
+        mergeSort(first, last, std::less<typename std::iterator_traits<It>::value_type>());
+    }
+
+    //并行样本排序
+    //1. 等距抽样，排序后选出num_buckets-1个分割点
+    //2. 每个块并行统计落入各桶的元素个数
+    //3. 按(桶, 块)顺序求前缀和，得到每个块在每个桶中的写入位置
+    //4. 每个块并行把元素分散到缓冲区
+    //5. 各桶并行排序后搬回原数组
+    template <typename It, typename Compare>
+    void sampleSort(It first, It last, Compare comp, std::ptrdiff_t grain = DEFAULT_GRAIN_SIZE) {
+        using T = typename std::iterator_traits<It>::value_type;
+        const std::ptrdiff_t n = last - first;
+        if (grain < 2) {
+            grain = 2;
+        }
+        if (n <= grain) {
+            serialSort(first, last, comp);
+            return;
+        }
+
+        const int concurrency = tbb::this_task_arena::max_concurrency();
+        const std::ptrdiff_t max_buckets = std::max<std::ptrdiff_t>(2, n / grain);
+        const int num_buckets = (int) std::min<std::ptrdiff_t>(4 * concurrency + 1, max_buckets);
+        const int oversample = 16;
+
+        //抽样
+        const std::ptrdiff_t num_samples = (std::ptrdiff_t) num_buckets * oversample;
+        std::vector<T> samples;
+        samples.reserve(num_samples);
+        for (std::ptrdiff_t s = 0; s < num_samples; ++s) {
+            samples.push_back(first[s * n / num_samples + n / (2 * num_samples)]);
+        }
+        serialSort(samples.begin(), samples.end(), comp);
+        std::vector<T> splitters;
+        splitters.reserve(num_buckets - 1);
+        for (int b = 1; b < num_buckets; ++b) {
+            splitters.push_back(samples[b * oversample]);
+        }
+        auto bucketOf = [&splitters, comp](const T &v) -> int {
+            return (int) (std::upper_bound(splitters.begin(), splitters.end(), v, comp) - splitters.begin());
+        };
+
+        //统计
+        const std::ptrdiff_t block_size = std::max<std::ptrdiff_t>(grain, n / (4 * concurrency));
+        const std::ptrdiff_t num_blocks = (n + block_size - 1) / block_size;
+        std::vector<std::ptrdiff_t> counts(num_blocks * num_buckets, 0);
+        tbb::parallel_for(std::ptrdiff_t(0), num_blocks, [&](std::ptrdiff_t k) {
+            std::ptrdiff_t *my_counts = &counts[k * num_buckets];
+            It bs = first + k * block_size;
+            It be = first + std::min(n, (k + 1) * block_size);
+            for (It i = bs; i != be; ++i) {
+                ++my_counts[bucketOf(*i)];
+            }
+        });
+
+        //前缀和，counts[k][b]变为写入偏移
+        std::vector<std::ptrdiff_t> bucket_start(num_buckets + 1, 0);
+        std::ptrdiff_t offset = 0;
+        for (int b = 0; b < num_buckets; ++b) {
+            bucket_start[b] = offset;
+            for (std::ptrdiff_t k = 0; k < num_blocks; ++k) {
+                std::ptrdiff_t c = counts[k * num_buckets + b];
+                counts[k * num_buckets + b] = offset;
+                offset += c;
+            }
+        }
+        bucket_start[num_buckets] = n;
+
+        //分散
+        std::vector<T> buffer(n);
+        tbb::parallel_for(std::ptrdiff_t(0), num_blocks, [&](std::ptrdiff_t k) {
+            std::ptrdiff_t *my_offsets = &counts[k * num_buckets];
+            It bs = first + k * block_size;
+            It be = first + std::min(n, (k + 1) * block_size);
+            for (It i = bs; i != be; ++i) {
+                buffer[my_offsets[bucketOf(*i)]++] = std::move(*i);
+            }
+        });
+
+        //桶内排序，重复值多时桶可能很大，因此桶内仍用并行归并排序
+        tbb::parallel_for(0, num_buckets, [&](int b) {
+            auto bs = buffer.begin() + bucket_start[b];
+            auto be = buffer.begin() + bucket_start[b + 1];
+            mergeSort(bs, be, comp, grain);
+            std::move(bs, be, first + bucket_start[b]);
+        });
+    }
+
+    template <typename It>
+    void sampleSort(It first, It last) {
+        sampleSort(first, last, std::less<typename std::iterator_traits<It>::value_type>());
+    }
+
+    //三路划分（Dijkstra），[first, lt) < pivot, [lt, gt) == pivot, [gt, last) > pivot
+    template <typename It, typename T, typename Compare>
+    std::pair<It, It> threeWayPartition(It first, It last, const T &pivot, Compare comp) {
+        It lt = first, i = first, gt = last;
+        while (i < gt) {
+            if (comp(*i, pivot)) {
+                std::iter_swap(lt++, i++);
+            } else if (comp(pivot, *i)) {
+                std::iter_swap(i, --gt);
+            } else {
+                ++i;
+            }
+        }
+        return std::make_pair(lt, gt);
+    }
+
+    //串行introsort的三路版本：取样中出现相等元素时认为重复值多，改用三路划分
+    //三路划分把等于基准的元素一次性排除，少量不同值的输入是线性的
+    template <typename It, typename Compare>
+    void introSort3Way(It first, It last, Compare comp, int depth_limit) {
+        while (last - first > INSERTION_THRESHOLD) {
+            if (depth_limit == 0) {
+                std::make_heap(first, last, comp);
+                std::sort_heap(first, last, comp);
+                return;
+            }
+            --depth_limit;
+            It mid = first + (last - first) / 2;
+            It p = choosePivot(first, last, comp);
+            auto equal = [&comp, p](It x) { return x != p && !comp(*x, *p) && !comp(*p, *x); };
+            if (equal(first) || equal(mid) || equal(last - 1)) {
+                auto pivot = *p;
+                std::pair<It, It> eq = threeWayPartition(first, last, pivot, comp);
+                if (eq.first - first < last - eq.second) {
+                    introSort3Way(first, eq.first, comp, depth_limit);
+                    first = eq.second;
+                } else {
+                    introSort3Way(eq.second, last, comp, depth_limit);
+                    last = eq.first;
+                }
+                continue;
+            }
+            std::iter_swap(first, p);
+            It q = partitionAtFirst(first, last, comp);
+            if (q - first < last - q) {
+                introSort3Way(first, q, comp, depth_limit);
+                first = q + 1;
+            } else {
+                introSort3Way(q + 1, last, comp, depth_limit);
+                last = q;
+            }
+        }
+        insertionSort(first, last, comp);
+    }
+
+    //分块并行划分，把满足pred的元素放到前面，返回分界点
+    //1. 切成若干块，每块并行地就地划分，得到[true..., false...]
+    //2. 全局分界点L = 各块true的个数之和
+    //3. [first, first+L)中的false和[first+L, last)中的true个数相同，按顺序一一配对并行交换
+    //和Tsigas/Zhang的思路一样是就地的块划分，只是把"中和"换成了统一的交换阶段
+    template <typename It, typename Pred>
+    It parallelPartition(It first, It last, Pred pred, std::ptrdiff_t grain = DEFAULT_GRAIN_SIZE) {
+        using Interval = std::pair<std::ptrdiff_t, std::ptrdiff_t>;
+        const std::ptrdiff_t n = last - first;
+        if (n <= grain) {
+            return std::partition(first, last, pred);
+        }
+        const std::ptrdiff_t concurrency = tbb::this_task_arena::max_concurrency();
+        const std::ptrdiff_t num_blocks = std::max<std::ptrdiff_t>(1, std::min(n / grain, 4 * concurrency));
+        const std::ptrdiff_t block_size = (n + num_blocks - 1) / num_blocks;
+
+        std::vector<std::ptrdiff_t> num_true(num_blocks);
+        tbb::parallel_for(std::ptrdiff_t(0), num_blocks, [&](std::ptrdiff_t k) {
+            It bs = first + std::min(n, k * block_size);
+            It be = first + std::min(n, (k + 1) * block_size);
+            num_true[k] = std::partition(bs, be, pred) - bs;
+        });
+
+        std::ptrdiff_t split = 0;
+        for (std::ptrdiff_t t : num_true) {
+            split += t;
+        }
+
+        //左边放错的false区间，右边放错的true区间，都按地址顺序
+        std::vector<Interval> wrong_left, wrong_right;
+        for (std::ptrdiff_t k = 0; k < num_blocks; ++k) {
+            const std::ptrdiff_t bs = std::min(n, k * block_size);
+            const std::ptrdiff_t bm = bs + num_true[k];
+            const std::ptrdiff_t be = std::min(n, (k + 1) * block_size);
+            if (bm < split && bm < be) {
+                wrong_left.emplace_back(bm, std::min(be, split));
+            }
+            if (bs < bm && split < bm) {
+                wrong_right.emplace_back(std::max(bs, split), bm);
+            }
+        }
+        auto prefixOf = [](const std::vector<Interval> &iv) {
+            std::vector<std::ptrdiff_t> prefix(iv.size() + 1, 0);
+            for (size_t i = 0; i < iv.size(); ++i) {
+                prefix[i + 1] = prefix[i] + iv[i].second - iv[i].first;
+            }
+            return prefix;
+        };
+        const std::vector<std::ptrdiff_t> left_prefix = prefixOf(wrong_left);
+        const std::vector<std::ptrdiff_t> right_prefix = prefixOf(wrong_right);
+        const std::ptrdiff_t num_swaps = left_prefix.back();
+
+        //第j个放错的元素的位置
+        auto locate = [](const std::vector<Interval> &iv, const std::vector<std::ptrdiff_t> &prefix, std::ptrdiff_t j) {
+            size_t idx = std::upper_bound(prefix.begin(), prefix.end(), j) - prefix.begin() - 1;
+            return std::make_pair(idx, iv[idx].first + (j - prefix[idx]));
+        };
+        tbb::parallel_for(tbb::blocked_range<std::ptrdiff_t>(0, num_swaps, grain),
+                          [&](const tbb::blocked_range<std::ptrdiff_t> &r) {
+            auto l = locate(wrong_left, left_prefix, r.begin());
+            auto rr = locate(wrong_right, right_prefix, r.begin());
+            for (std::ptrdiff_t j = r.begin(); j != r.end(); ++j) {
+                if (l.second == wrong_left[l.first].second) {
+                    ++l.first;
+                    l.second = wrong_left[l.first].first;
+                }
+                if (rr.second == wrong_right[rr.first].second) {
+                    ++rr.first;
+                    rr.second = wrong_right[rr.first].first;
+                }
+                std::iter_swap(first + l.second++, first + rr.second++);
+            }
+        });
+        return first + split;
+    }
+
+    //并行判断是否有序，非有序的块在第一个逆序处就停下，随机输入几乎没有开销
+    template <typename It, typename Compare>
+    bool parallelIsSorted(It first, It last, Compare comp, std::ptrdiff_t grain = DEFAULT_GRAIN_SIZE) {
+        const std::ptrdiff_t n = last - first;
+        if (n < 2) {
+            return true;
+        }
+        return tbb::parallel_reduce(
+                tbb::blocked_range<std::ptrdiff_t>(0, n - 1, grain),
+                true,
+                [=](const tbb::blocked_range<std::ptrdiff_t> &r, bool sorted) -> bool {
+                    //每块多看一个元素，覆盖块之间的边界
+                    return sorted && std::is_sorted(first + r.begin(), first + r.end() + 1, comp);
+                },
+                [](bool x, bool y) -> bool {
+                    return x && y;
+                }
+        );
+    }
+
+    //并行快速排序的递归部分
+    //bad_allowed：还允许出现几次很不均衡的划分，用完后改用并行归并排序，保证O(NlogN)
+    template <typename It, typename Compare>
+    void quickSortImpl(It first, It last, Compare comp, std::ptrdiff_t grain, int bad_allowed) {
+        const std::ptrdiff_t n = last - first;
+        if (n <= grain) {
+            introSort3Way(first, last, comp, depthLimit(n));
+            return;
+        }
+        if (bad_allowed == 0) {
+            mergeSort(first, last, comp, grain);
+            return;
+        }
+        //拷贝一份基准值，划分过程中元素会被移动
+        auto pivot = *choosePivot(first, last, comp);
+        It lt = parallelPartition(first, last, [&](const auto &x) { return comp(x, pivot); }, grain);
+        It gt = parallelPartition(lt, last, [&](const auto &x) { return !comp(pivot, x); }, grain);
+        //较小的一边不足1/8认为基准选得不好
+        if (std::min(lt - first, last - gt) < n / 8) {
+            --bad_allowed;
+        }
+        tbb::parallel_invoke(
+                [=]() { quickSortImpl(first, lt, comp, grain, bad_allowed); },
+                [=]() { quickSortImpl(gt, last, comp, grain, bad_allowed); }
+        );
+    }
+
+    //并行快速排序：九数取中选基准，两次并行划分得到三路（<, ==, >），
+    //划分质量差的次数过多时退化为并行归并排序；有序和逆序输入直接识别出来
+    template <typename It, typename Compare>
+    void quickSort(It first, It last, Compare comp, std::ptrdiff_t grain = DEFAULT_GRAIN_SIZE) {
+        const std::ptrdiff_t n = last - first;
+        if (grain < 2) {
+            grain = 2;
+        }
+        if (n <= grain) {
+            introSort3Way(first, last, comp, depthLimit(n));
+            return;
+        }
+        if (parallelIsSorted(first, last, comp, grain)) {
+            return;
+        }
+        //非严格递减，翻转后就是非严格递增
+        auto reversed_comp = [comp](const auto &x, const auto &y) { return comp(y, x); };
+        if (parallelIsSorted(first, last, reversed_comp, grain)) {
+            tbb::parallel_for(tbb::blocked_range<std::ptrdiff_t>(0, n / 2, grain),
+                              [=](const tbb::blocked_range<std::ptrdiff_t> &r) {
+                                  for (std::ptrdiff_t i = r.begin(); i != r.end(); ++i) {
+                                      std::iter_swap(first + i, last - 1 - i);
+                                  }
+                              });
+            return;
+        }
+        quickSortImpl(first, last, comp, grain, depthLimit(n) / 2);
+    }
+
+    template <typename It>
+    void quickSort(It first, It last) {
+        quickSort(first, last, std::less<typename std::iterator_traits<It>::value_type>());
+    }
+
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <tbb/tbb.h>
+
+namespace RadixSort {
+
+    //每趟处理8位，32位整数4趟，64位整数8趟
+    const int RADIX_BITS = 8;
+    const int RADIX = 1 << RADIX_BITS;
+    //小于该长度直接串行稳定排序
+    const std::size_t SERIAL_THRESHOLD = 1 << 12;
+    //每个块至少这么多元素，块内统计和分散都是串行的
+    const std::size_t MIN_BLOCK_SIZE = 1 << 16;
+    //写合并缓冲区，每个桶攒够一条cache line再写出
+    const std::size_t WC_BYTES = 64;
+
+    //有符号整数翻转符号位，使无符号比较的顺序与有符号一致
+    template <typename K>
+    inline std::make_unsigned_t<K> toUnsigned(K k) {
+        using U = std::make_unsigned_t<K>;
+        if constexpr (std::is_signed_v<K>) {
+            return (U) k ^ (U(1) << (sizeof(K) * 8 - 1));
+        } else {
+            return k;
+        }
+    }
+
+    //元素本身就是键
+    struct IdentityKey {
+        template <typename T>
+        T operator()(const T &v) const { return v; }
+    };
+
+    //std::pair<键, 值>，按first排序
+    struct PairKey {
+        template <typename K, typename V>
+        K operator()(const std::pair<K, V> &p) const { return p.first; }
+    };
+
+    template <typename T, typename KeyOf>
+    using KeyType = std::decay_t<decltype(std::declval<KeyOf>()(std::declval<const T &>()))>;
+
+    template <typename T>
+    constexpr std::size_t wcSize() {
+        return sizeof(T) >= WC_BYTES ? 1 : WC_BYTES / sizeof(T);
+    }
+
+    inline std::size_t blockSize(std::size_t n) {
+        const std::size_t concurrency = tbb::this_task_arena::max_concurrency();
+        return std::max(MIN_BLOCK_SIZE, (n + 4 * concurrency - 1) / (4 * concurrency));
+    }
+
+    //按键串行稳定排序
+    template <typename T, typename KeyOf>
+    void serialSort(T *first, T *last, KeyOf key) {
+        std::stable_sort(first, last, [key](const T &x, const T &y) {
+            return toUnsigned(key(x)) < toUnsigned(key(y));
+        });
+    }
+
+    //一趟计数排序，按第shift位开始的RADIX_BITS位把src稳定地分散到dst
+    //1. 每个块并行统计直方图，counts按(数位, 块)排列
+    //2. parallel_scan求出每个块在每个数位上的写入偏移
+    //3. 每个块并行分散，经写合并缓冲区写出
+    //digit_start非空时返回各数位的起始位置（RADIX+1个）
+    //所有元素该位都相同时跳过，返回false，此时dst未被写入
+    template <typename T, typename KeyOf>
+    bool radixPass(const T *src, T *dst, std::size_t n, int shift, KeyOf key,
+                   std::size_t block_size, std::size_t *digit_start = nullptr) {
+        const std::size_t num_blocks = (n + block_size - 1) / block_size;
+        auto digitOf = [shift, key](const T &v) -> unsigned {
+            return (unsigned) (toUnsigned(key(v)) >> shift) & (RADIX - 1);
+        };
+
+        //直方图
+        std::vector<std::size_t> counts(RADIX * num_blocks);
+        tbb::parallel_for(std::size_t(0), num_blocks, [&](std::size_t k) {
+            std::size_t local[RADIX] = {0};
+            const T *bs = src + k * block_size;
+            const T *be = src + std::min(n, (k + 1) * block_size);
+            for (const T *p = bs; p != be; ++p) {
+                ++local[digitOf(*p)];
+            }
+            for (int d = 0; d < RADIX; ++d) {
+                counts[d * num_blocks + k] = local[d];
+            }
+        });
+
+        bool trivial = false;
+        std::size_t start = 0;
+        for (int d = 0; d < RADIX; ++d) {
+            std::size_t total = 0;
+            for (std::size_t k = 0; k < num_blocks; ++k) {
+                total += counts[d * num_blocks + k];
+            }
+            if (digit_start) {
+                digit_start[d] = start;
+            }
+            start += total;
+            trivial |= (total == n);
+        }
+        if (digit_start) {
+            digit_start[RADIX] = n;
+        }
+        if (trivial) {
+            return false;
+        }
+
+        //前缀和（不包含自身），得到写入偏移
+        std::vector<std::size_t> offsets(counts.size());
+        tbb::parallel_scan(
+                tbb::blocked_range<std::size_t>(0, counts.size()),
+                std::size_t(0),
+                [&counts, &offsets](const tbb::blocked_range<std::size_t> &r, std::size_t sum, bool is_final_scan) -> std::size_t {
+                    for (std::size_t i = r.begin(); i < r.end(); ++i) {
+                        if (is_final_scan) {
+                            offsets[i] = sum;
+                        }
+                        sum += counts[i];
+                    }
+                    return sum;
+                },
+                [](std::size_t x, std::size_t y) {
+                    return x + y;
+                }
+        );
+
+        //分散
+        constexpr std::size_t WC = wcSize<T>();
+        using Buffer = std::vector<T>;
+        tbb::enumerable_thread_specific<Buffer> wc_buffers([]() { return Buffer(RADIX * WC); });
+        tbb::parallel_for(std::size_t(0), num_blocks, [&](std::size_t k) {
+            T *buf = wc_buffers.local().data();
+            std::size_t fill[RADIX] = {0};
+            std::size_t pos[RADIX];
+            for (int d = 0; d < RADIX; ++d) {
+                pos[d] = offsets[d * num_blocks + k];
+            }
+            const T *bs = src + k * block_size;
+            const T *be = src + std::min(n, (k + 1) * block_size);
+            for (const T *p = bs; p != be; ++p) {
+                unsigned d = digitOf(*p);
+                T *line = buf + d * WC;
+                line[fill[d]++] = *p;
+                if (fill[d] == WC) {
+                    std::copy(line, line + WC, dst + pos[d]);
+                    pos[d] += WC;
+                    fill[d] = 0;
+                }
+            }
+            for (int d = 0; d < RADIX; ++d) {
+                std::copy(buf + d * WC, buf + d * WC + fill[d], dst + pos[d]);
+            }
+        });
+        return true;
+    }
+
+    //在a、b之间来回做[first_digit, last_digit)这几趟，返回结果所在的那块内存
+    template <typename T, typename KeyOf>
+    T *lsdPasses(T *a, T *b, std::size_t n, int first_digit, int last_digit, KeyOf key) {
+        const std::size_t block_size = blockSize(n);
+        for (int d = first_digit; d < last_digit; ++d) {
+            if (radixPass(a, b, n, d * RADIX_BITS, key, block_size)) {
+                std::swap(a, b);
+            }
+        }
+        return a;
+    }
+
+    template <typename T>
+    void parallelCopy(const T *src, std::size_t n, T *dst) {
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, n, MIN_BLOCK_SIZE),
+                          [src, dst](const tbb::blocked_range<std::size_t> &r) {
+                              std::copy(src + r.begin(), src + r.end(), dst + r.begin());
+                          });
+    }
+
+    //LSD基数排序，从最低位到最高位，每趟都是稳定的并行计数排序
+    template <typename T, typename KeyOf = IdentityKey>
+    void lsdSort(T *first, T *last, KeyOf key = KeyOf()) {
+        const std::size_t n = last - first;
+        if (n < SERIAL_THRESHOLD) {
+            serialSort(first, last, key);
+            return;
+        }
+        const int num_digits = sizeof(KeyType<T, KeyOf>) * 8 / RADIX_BITS;
+        std::vector<T> tmp(n);
+        T *res = lsdPasses(first, tmp.data(), n, 0, num_digits, key);
+        if (res != first) {
+            parallelCopy(res, n, first);
+        }
+    }
+
+    //MSD基数排序：先按最高位并行分桶，各桶再并行地对剩下的低位做LSD
+    //分桶之后每个桶的数据量小、更容易留在cache里
+    template <typename T, typename KeyOf = IdentityKey>
+    void msdSort(T *first, T *last, KeyOf key = KeyOf()) {
+        const std::size_t n = last - first;
+        if (n < SERIAL_THRESHOLD) {
+            serialSort(first, last, key);
+            return;
+        }
+        const int top = sizeof(KeyType<T, KeyOf>) * 8 / RADIX_BITS - 1;
+        std::vector<T> tmp(n);
+        std::size_t digit_start[RADIX + 1];
+        bool moved = radixPass((const T *) first, tmp.data(), n, top * RADIX_BITS, key, blockSize(n), digit_start);
+        T *src = moved ? tmp.data() : first;
+        T *other = moved ? first : tmp.data();
+
+        tbb::parallel_for(0, RADIX, [&](int d) {
+            const std::size_t start = digit_start[d];
+            const std::size_t len = digit_start[d + 1] - start;
+            if (len == 0) {
+                return;
+            }
+            T *res = src + start;
+            if (len < SERIAL_THRESHOLD) {
+                serialSort(res, res + len, key);
+            } else {
+                res = lsdPasses(src + start, other + start, len, 0, top, key);
+            }
+            if (res != first + start) {
+                std::copy(res, res + len, first + start);
+            }
+        });
+    }
+
+}
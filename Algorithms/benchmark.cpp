@@ -0,0 +1,216 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <tbb/tbb.h>
+#include "ParallelSort.h"
+#include "RadixSort.h"
+
+//排序基准测试
+//用法：SortBenchmark [最大元素个数，默认1e6] [最大线程数，默认全部核]
+//元素个数从1e4开始每次乘10，线程数从1开始每次乘2，
+//输出每种(元素类型, 分布, 个数, 算法, 线程数)的耗时、每秒元素数和相对单线程的加速比
+
+//16字节记录：8字节键+8字节负载
+struct Record {
+    std::uint64_t key;
+    std::uint64_t payload;
+    bool operator<(const Record &other) const { return key < other.key; }
+};
+
+struct RecordKey {
+    std::uint64_t operator()(const Record &r) const { return r.key; }
+};
+
+enum class Distribution { Uniform, Sorted, Reverse, FewUnique, Zipf, OrganPipe };
+
+const char *distributionName(Distribution d) {
+    switch (d) {
+        case Distribution::Uniform: return "uniform";
+        case Distribution::Sorted: return "sorted";
+        case Distribution::Reverse: return "reverse";
+        case Distribution::FewUnique: return "few_unique";
+        case Distribution::Zipf: return "zipf";
+        case Distribution::OrganPipe: return "organ_pipe";
+    }
+    return "";
+}
+
+//Zipf分布的累积概率，排名k的概率正比于1/k^s
+std::vector<double> zipfCdf(size_t num_ranks, double s) {
+    std::vector<double> cdf(num_ranks);
+    double sum = 0;
+    for (size_t k = 0; k < num_ranks; ++k) {
+        sum += 1.0 / std::pow((double) (k + 1), s);
+        cdf[k] = sum;
+    }
+    for (auto &c : cdf) {
+        c /= sum;
+    }
+    return cdf;
+}
+
+//按分布并行生成键，每块用自己的随机数种子，结果与线程数无关
+std::vector<std::uint64_t> makeKeys(Distribution d, size_t n) {
+    std::vector<std::uint64_t> keys(n);
+    const size_t block = 1 << 16;
+    std::vector<double> cdf;
+    if (d == Distribution::Zipf) {
+        cdf = zipfCdf(std::min<size_t>(std::max<size_t>(n, 1), 1 << 20), 1.1);
+    }
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, n, block),
+        [&](const tbb::blocked_range<size_t> &r) {
+            std::mt19937_64 rng(r.begin() * 0x9e3779b97f4a7c15ULL + 12345);
+            std::uniform_real_distribution<double> uniform01(0.0, 1.0);
+            for (size_t i = r.begin(); i != r.end(); ++i) {
+                switch (d) {
+                    case Distribution::Uniform: keys[i] = rng(); break;
+                    case Distribution::Sorted: keys[i] = i; break;
+                    case Distribution::Reverse: keys[i] = n - i; break;
+                    case Distribution::FewUnique: keys[i] = rng() % 16; break;
+                    case Distribution::Zipf:
+                        keys[i] = std::lower_bound(cdf.begin(), cdf.end(), uniform01(rng)) - cdf.begin();
+                        break;
+                    case Distribution::OrganPipe: keys[i] = (i < n / 2) ? i : n - i; break;
+                }
+            }
+        });
+    return keys;
+}
+
+template <typename T> T makeElement(std::uint64_t key, size_t i);
+template <> int makeElement<int>(std::uint64_t key, size_t) { return (int) (key >> 33) ^ (int) (key & 0x7fffffff); }
+template <> double makeElement<double>(std::uint64_t key, size_t) { return (double) key; }
+template <> Record makeElement<Record>(std::uint64_t key, size_t i) { return Record{key, i}; }
+template <> std::string makeElement<std::string>(std::uint64_t key, size_t) {
+    //补零到20位，字典序和数值序一致，且超出短字符串优化的长度
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "%020llu", (unsigned long long) key);
+    return buf;
+}
+
+template <typename T>
+std::vector<T> makeInput(Distribution d, size_t n) {
+    std::vector<std::uint64_t> keys = makeKeys(d, n);
+    //int只取有序分布的低32位，否则高位截断会打乱sorted/reverse
+    const bool ordered = (d != Distribution::Uniform);
+    std::vector<T> data(n);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, n),
+        [&](const tbb::blocked_range<size_t> &r) {
+            for (size_t i = r.begin(); i != r.end(); ++i) {
+                if constexpr (std::is_same_v<T, int>) {
+                    data[i] = ordered ? (int) keys[i] : makeElement<int>(keys[i], i);
+                } else {
+                    data[i] = makeElement<T>(keys[i], i);
+                }
+            }
+        });
+    return data;
+}
+
+template <typename T>
+struct SortAlgorithm {
+    const char *name;
+    void (*sort)(std::vector<T> &);
+};
+
+template <typename T>
+std::vector<SortAlgorithm<T>> algorithmsFor() {
+    std::vector<SortAlgorithm<T>> algos = {
+        {"std::sort", [](std::vector<T> &v) { std::sort(v.begin(), v.end()); }},
+        {"tbb::parallel_sort", [](std::vector<T> &v) { tbb::parallel_sort(v.begin(), v.end()); }},
+        {"mergeSort", [](std::vector<T> &v) { ParallelSort::mergeSort(v.begin(), v.end()); }},
+        {"sampleSort", [](std::vector<T> &v) { ParallelSort::sampleSort(v.begin(), v.end()); }},
+        {"quickSort", [](std::vector<T> &v) { ParallelSort::quickSort(v.begin(), v.end()); }},
+    };
+    if constexpr (std::is_same_v<T, int>) {
+        algos.push_back({"lsdRadixSort", [](std::vector<T> &v) { RadixSort::lsdSort(v.data(), v.data() + v.size()); }});
+        algos.push_back({"msdRadixSort", [](std::vector<T> &v) { RadixSort::msdSort(v.data(), v.data() + v.size()); }});
+    }
+    if constexpr (std::is_same_v<T, Record>) {
+        algos.push_back({"lsdRadixSort", [](std::vector<T> &v) { RadixSort::lsdSort(v.data(), v.data() + v.size(), RecordKey()); }});
+        algos.push_back({"msdRadixSort", [](std::vector<T> &v) { RadixSort::msdSort(v.data(), v.data() + v.size(), RecordKey()); }});
+    }
+    return algos;
+}
+
+//小规模多跑几次取最快，大规模只跑一次
+template <typename T>
+double timeAlgorithm(const SortAlgorithm<T> &algo, const std::vector<T> &input) {
+    const int repeats = input.size() <= 1000000 ? 3 : 1;
+    double best = 1e300;
+    for (int rep = 0; rep < repeats; ++rep) {
+        std::vector<T> data = input;
+        tbb::tick_count t0 = tbb::tick_count::now();
+        algo.sort(data);
+        best = std::min(best, (tbb::tick_count::now() - t0).seconds());
+        if (!std::is_sorted(data.begin(), data.end())) {
+            std::cerr << "  " << algo.name << " produced unsorted output" << std::endl;
+        }
+    }
+    return best;
+}
+
+template <typename T>
+void benchmarkType(const char *type_name, size_t max_n, const std::vector<int> &thread_counts) {
+    const Distribution distributions[] = {Distribution::Uniform, Distribution::Sorted, Distribution::Reverse,
+                                          Distribution::FewUnique, Distribution::Zipf, Distribution::OrganPipe};
+    for (Distribution d : distributions) {
+        for (size_t n = 10000; n <= max_n; n *= 10) {
+            std::vector<T> input = makeInput<T>(d, n);
+            for (const auto &algo : algorithmsFor<T>()) {
+                double base = 0;
+                for (int threads : thread_counts) {
+                    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+                    double t = timeAlgorithm(algo, input);
+                    if (threads == thread_counts.front()) {
+                        base = t;
+                    }
+                    std::cout << std::left << std::setw(8) << type_name
+                              << std::setw(12) << distributionName(d)
+                              << std::setw(12) << n
+                              << std::setw(20) << algo.name
+                              << std::setw(4) << threads
+                              << std::right << std::fixed << std::setprecision(6)
+                              << std::setw(12) << t
+                              << std::setprecision(2)
+                              << std::setw(12) << n / t / 1e6
+                              << std::setw(8) << base / t
+                              << std::defaultfloat << std::endl;
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t max_n = argc > 1 ? (size_t) std::atof(argv[1]) : 1000000;
+    int max_threads = argc > 2 ? std::atoi(argv[2]) : tbb::info::default_concurrency();
+
+    std::vector<int> thread_counts;
+    for (int t = 1; t < max_threads; t *= 2) {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(max_threads);
+
+    //空转，让scheduler warmup
+    tbb::parallel_for(0, max_threads, [](int) {
+        tbb::tick_count t0 = tbb::tick_count::now();
+        while ((tbb::tick_count::now() - t0).seconds() < 0.01);
+    });
+
+    std::cout << std::left << std::setw(8) << "type" << std::setw(12) << "dist" << std::setw(12) << "n"
+              << std::setw(20) << "algorithm" << std::setw(4) << "thr" << std::right << std::setw(12) << "seconds"
+              << std::setw(12) << "Melem/s" << std::setw(8) << "speedup" << std::endl;
+    benchmarkType<int>("int", max_n, thread_counts);
+    benchmarkType<double>("double", max_n, thread_counts);
+    benchmarkType<Record>("record", max_n, thread_counts);
+    //字符串占用内存大、比较慢，规模少一个数量级
+    benchmarkType<std::string>("string", max_n / 10, thread_counts);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <tbb/tbb.h>
+#include "ExternalSort.h"
+
+//外部排序
+//用法：
+//  ExternalSort <输入文件> <输出文件> [内存预算MB，默认256] [类型u32|i32|u64|i64|f64，默认u32]
+//  ExternalSort --generate <文件> <元素个数> [类型]
+//不带参数时生成一个测试文件，用很小的内存预算排序并检查结果；预算为1MB时run很多，要分多趟归并
+
+//生成随机数据文件，分块写出
+template <typename T>
+void generateFile(const std::string &path, std::uint64_t n) {
+    std::ofstream out(path, std::ios::binary);
+    std::mt19937_64 rng(2023);
+    std::vector<T> block(1 << 20);
+    for (std::uint64_t done = 0; done < n; done += block.size()) {
+        std::size_t count = (std::size_t) std::min<std::uint64_t>(block.size(), n - done);
+        for (std::size_t i = 0; i < count; ++i) {
+            block[i] = (T) rng();
+        }
+        out.write((const char *) block.data(), count * sizeof(T));
+    }
+}
+
+//顺序读回，检查有序，并用与顺序无关的校验和检查元素没有丢失
+template <typename T>
+std::uint64_t checksum(const std::string &path, bool *sorted) {
+    static_assert(sizeof(T) <= sizeof(std::uint64_t), "checksum adds raw bit patterns");
+    std::ifstream in(path, std::ios::binary);
+    std::vector<T> block(1 << 20);
+    std::uint64_t sum = 0;
+    bool first = true;
+    T prev{};
+    *sorted = true;
+    while (in) {
+        in.read((char *) block.data(), block.size() * sizeof(T));
+        std::size_t got = in.gcount() / sizeof(T);
+        for (std::size_t i = 0; i < got; ++i) {
+            if (!first && block[i] < prev) {
+                *sorted = false;
+            }
+            prev = block[i];
+            first = false;
+            //按位模式相加（模2^64），与顺序无关且没有浮点舍入
+            std::uint64_t bits = 0;
+            std::memcpy(&bits, &block[i], sizeof(T));
+            sum += bits;
+        }
+    }
+    return sum;
+}
+
+template <typename T>
+int runSort(const std::string &input, const std::string &output, std::size_t memory_bytes) {
+    ExternalSort::Stats stats;
+    if (!ExternalSort::sortFile<T>(input, output, memory_bytes, &stats)) {
+        return 1;
+    }
+    std::cout << "elements:    " << stats.num_elems << std::endl;
+    std::cout << "runs:        " << stats.num_runs << std::endl;
+    std::cout << "passes:      " << stats.merge_passes << std::endl;
+    std::cout << "run time:    " << stats.run_seconds << std::endl;
+    std::cout << "merge time:  " << stats.merge_seconds << std::endl;
+    std::cout << "Melem/s:     " << stats.num_elems / (stats.run_seconds + stats.merge_seconds) / 1e6 << std::endl;
+    return 0;
+}
+
+template <typename T>
+int dispatch(int argc, char **argv) {
+    if (std::string(argv[1]) == "--generate") {
+        generateFile<T>(argv[2], (std::uint64_t) std::atof(argv[3]));
+        return 0;
+    }
+    std::size_t memory_mb = argc > 3 ? std::atoi(argv[3]) : ExternalSort::DEFAULT_MEMORY_BYTES >> 20;
+    return runSort<T>(argv[1], argv[2], memory_mb << 20);
+}
+
+int main(int argc, char **argv) {
+    if (argc == 1) {
+        //自检：64MB数据，8MB内存预算时一趟归并多个run，1MB时run超过一次归并的上限
+        const std::string input = "external_input.bin", output = "external_output.bin";
+        generateFile<std::uint32_t>(input, std::uint64_t(1) << 24);
+        bool in_sorted;
+        std::uint64_t in_sum = checksum<std::uint32_t>(input, &in_sorted);
+        int ret = 0;
+        for (std::size_t memory_mb : {8, 1}) {
+            bool out_sorted;
+            if (runSort<std::uint32_t>(input, output, memory_mb << 20) != 0 ||
+                checksum<std::uint32_t>(output, &out_sorted) != in_sum || !out_sorted) {
+                std::cerr << "External sort failed with " << memory_mb << " MB!!" << std::endl;
+                ret = 1;
+            }
+            std::filesystem::remove(output);
+        }
+        std::filesystem::remove(input);
+        return ret;
+    }
+    if (argc < 3 || (std::string(argv[1]) == "--generate" && argc < 4)) {
+        std::cerr << "usage: ExternalSort <input> <output> [memory_MB] [u32|i32|u64|i64|f64]" << std::endl;
+        std::cerr << "       ExternalSort --generate <file> <count> [u32|i32|u64|i64|f64]" << std::endl;
+        return 1;
+    }
+    //两种用法的类型都是第4个参数
+    const std::string type = argc > 4 ? argv[4] : "u32";
+    if (type == "u32") return dispatch<std::uint32_t>(argc, argv);
+    if (type == "i32") return dispatch<std::int32_t>(argc, argv);
+    if (type == "u64") return dispatch<std::uint64_t>(argc, argv);
+    if (type == "i64") return dispatch<std::int64_t>(argc, argv);
+    if (type == "f64") return dispatch<double>(argc, argv);
+    std::cerr << "Error: unknown type " << type << std::endl;
+    return 1;
+}
@@ -1,6 +1,10 @@
 #include <iostream>
 #include <vector>
+#include <random>
+#include <string>
 #include <tbb/tbb.h>
+#include "ParallelSort.h"
+#include "RadixSort.h"
 
 using QV = std::vector<int>;
 
@@ -41,7 +45,7 @@ void parallelCutoffQuicksort(QV::iterator left, QV::iterator right){
     const int cutoff = 100;
 
     if (right - left < cutoff) {
-        quickSort(right, left);
+        quickSort(left, right);
     }
     else {
         int pivot_value =  *left;
@@ -55,29 +59,205 @@ void parallelCutoffQuicksort(QV::iterator left, QV::iterator right){
 
         // recursive call
         tbb::parallel_invoke(
-                [=]() { parallelQuicksort(left, i); },
-                [=]() { parallelQuicksort(i + 1, right); }
+                [=]() { parallelCutoffQuicksort(left, i); },
+                [=]() { parallelCutoffQuicksort(i + 1, right); }
         );
     }
 }
 
-int main() {
-    std::vector<int> nums;
-    for(int i = 0; i < 5000; ++i){
-        nums.push_back(rand() % 5000);
+//正确性检查：和std::sort的结果逐个比较
+template <typename T, typename Compare, typename Sort>
+bool checkSort(const char *name, std::vector<T> data, Compare comp, Sort sort){
+    std::vector<T> expected = data;
+    std::sort(expected.begin(), expected.end(), comp);
+    sort(data.begin(), data.end(), comp);
+    if(data != expected){
+        std::cerr << "  " << name << " failed, size=" << data.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//各种长度、分布、比较器、元素类型
+template <typename Sort>
+bool testSort(const char *name, Sort sort){
+    std::mt19937 rng(42);
+    const size_t sizes[] = {0, 1, 2, 3, 31, 32, 33, 127, 128, 1000,
+                            (size_t)ParallelSort::DEFAULT_GRAIN_SIZE - 1,
+                            (size_t)ParallelSort::DEFAULT_GRAIN_SIZE + 1,
+                            100000, 1000003};
+    bool ok = true;
+    for(size_t n : sizes){
+        std::vector<int> uniform(n), sorted(n), reversed(n), few_unique(n), equal(n, 7), organ(n);
+        for(size_t i = 0; i < n; ++i){
+            uniform[i] = (int)rng();
+            sorted[i] = (int)i;
+            reversed[i] = (int)(n - i);
+            few_unique[i] = (int)(rng() % 4);
+            organ[i] = (int)(i < n / 2 ? i : n - i);
+        }
+        for(auto *v : {&uniform, &sorted, &reversed, &few_unique, &equal, &organ}){
+            ok &= checkSort(name, *v, std::less<int>(), sort);
+            ok &= checkSort(name, *v, std::greater<int>(), sort);
+        }
+        if(n <= 100000){
+            std::vector<std::string> words(n);
+            for(size_t i = 0; i < n; ++i){
+                words[i] = std::to_string(rng() % 1000);
+            }
+            ok &= checkSort(name, words, std::less<std::string>(), sort);
+        }
+    }
+    std::cout << name << (ok ? " passed" : " FAILED") << std::endl;
+    return ok;
+}
+
+//基数排序检查：各种整数类型，以及键值对的稳定性
+template <typename T, typename Gen>
+bool checkRadix(const char *name, size_t n, Gen gen){
+    std::vector<T> data(n);
+    for(auto &v : data){
+        v = gen();
+    }
+    std::vector<T> expected = data, lsd = data, msd = data;
+    std::sort(expected.begin(), expected.end());
+    RadixSort::lsdSort(lsd.data(), lsd.data() + n);
+    RadixSort::msdSort(msd.data(), msd.data() + n);
+    if(lsd != expected || msd != expected){
+        std::cerr << "  radix sort " << name << " failed, size=" << n << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool testRadixSort(){
+    std::mt19937_64 rng(7);
+    bool ok = true;
+    for(size_t n : {0, 1, 100, 4095, 4096, 100000, 1000003}){
+        ok &= checkRadix<int32_t>("int32", n, [&]{ return (int32_t)rng(); });
+        ok &= checkRadix<uint32_t>("uint32", n, [&]{ return (uint32_t)rng(); });
+        ok &= checkRadix<int64_t>("int64", n, [&]{ return (int64_t)rng(); });
+        ok &= checkRadix<uint64_t>("uint64", n, [&]{ return (uint64_t)rng(); });
+        ok &= checkRadix<int32_t>("int32 few unique", n, [&]{ return (int32_t)(rng() % 3) - 1; });
+        ok &= checkRadix<uint64_t>("uint64 narrow", n, [&]{ return (uint64_t)(rng() % 1000); });
+
+        //键值对：值记录原始位置，和std::stable_sort比较以检查稳定性
+        using KV = std::pair<uint32_t, uint32_t>;
+        std::vector<KV> kv(n);
+        for(size_t i = 0; i < n; ++i){
+            kv[i] = KV((uint32_t)(rng() % 5000), (uint32_t)i);
+        }
+        std::vector<KV> expected = kv, lsd = kv, msd = kv;
+        std::stable_sort(expected.begin(), expected.end(),
+                         [](const KV &x, const KV &y){ return x.first < y.first; });
+        RadixSort::lsdSort(lsd.data(), lsd.data() + n, RadixSort::PairKey());
+        RadixSort::msdSort(msd.data(), msd.data() + n, RadixSort::PairKey());
+        if(lsd != expected || msd != expected){
+            std::cerr << "  radix sort key-value failed, size=" << n << std::endl;
+            ok = false;
+        }
+    }
+    std::cout << "RadixSort" << (ok ? " passed" : " FAILED") << std::endl;
+    return ok;
+}
+
+template <typename Sort>
+double timeSort(std::vector<int> data, Sort sort){
+    tbb::tick_count t0 = tbb::tick_count::now();
+    sort(data.begin(), data.end());
+    double t = (tbb::tick_count::now() - t0).seconds();
+    if(!std::is_sorted(data.begin(), data.end())){
+        std::cerr << "  result is not sorted" << std::endl;
     }
+    return t;
+}
+
+int main() {
+    //空转，让scheduler warmup
     tbb::parallel_for(0, 10, [](int) {
         tbb::tick_count t0 = tbb::tick_count::now();
         while ((tbb::tick_count::now() - t0).seconds() < 0.01);
     });
 
-    std::vector<int> nums2 = nums;
-    tbb::tick_count t0 = tbb::tick_count::now();
-    quickSort(nums.begin(), nums.end());
-    std::cout << "Normal Time=" << (tbb::tick_count::now() - t0).seconds() << std::endl;
+    //正确性
+    bool ok = true;
+    ok &= testSort("std::sort", [](auto first, auto last, auto comp){ std::sort(first, last, comp); });
+    ok &= testSort("ParallelSort::serialSort", [](auto first, auto last, auto comp){
+        ParallelSort::serialSort(first, last, comp);
+    });
+    ok &= testSort("ParallelSort::mergeSort", [](auto first, auto last, auto comp){
+        ParallelSort::mergeSort(first, last, comp);
+    });
+    ok &= testSort("ParallelSort::sampleSort", [](auto first, auto last, auto comp){
+        ParallelSort::sampleSort(first, last, comp);
+    });
+    ok &= testSort("ParallelSort::quickSort", [](auto first, auto last, auto comp){
+        ParallelSort::quickSort(first, last, comp);
+    });
+    ok &= testSort("ParallelSort::quickSort(grain=64)", [](auto first, auto last, auto comp){
+        ParallelSort::quickSort(first, last, comp, 64);
+    });
+    ok &= testRadixSort();
+    if(!ok){
+        return 1;
+    }
 
-    tbb::tick_count t1 = tbb::tick_count::now();
-    parallelQuicksort(nums2.begin(), nums2.end());
-    std::cout << "Parallel Time=" << (tbb::tick_count::now() - t1).seconds() << std::endl;
+    //性能
+    const int N = 1 << 23;
+    std::mt19937 rng(2023);
+    std::vector<int> nums(N);
+    for(int i = 0; i < N; ++i){
+        nums[i] = (int)rng();
+    }
+    std::cout << "N=" << N << std::endl;
+    std::cout << "Normal Time=" << timeSort(nums, [](auto first, auto last){
+        quickSort(first, last);
+    }) << std::endl;
+    std::cout << "Parallel Cutoff Time=" << timeSort(nums, [](auto first, auto last){
+        parallelCutoffQuicksort(first, last);
+    }) << std::endl;
+    std::cout << "std::sort Time=" << timeSort(nums, [](auto first, auto last){
+        std::sort(first, last);
+    }) << std::endl;
+    std::cout << "tbb::parallel_sort Time=" << timeSort(nums, [](auto first, auto last){
+        tbb::parallel_sort(first, last);
+    }) << std::endl;
+    std::cout << "Merge Sort Time=" << timeSort(nums, [](auto first, auto last){
+        ParallelSort::mergeSort(first, last);
+    }) << std::endl;
+    std::cout << "Sample Sort Time=" << timeSort(nums, [](auto first, auto last){
+        ParallelSort::sampleSort(first, last);
+    }) << std::endl;
+    std::cout << "LSD Radix Sort Time=" << timeSort(nums, [](auto first, auto last){
+        RadixSort::lsdSort(&*first, &*first + (last - first));
+    }) << std::endl;
+    std::cout << "MSD Radix Sort Time=" << timeSort(nums, [](auto first, auto last){
+        RadixSort::msdSort(&*first, &*first + (last - first));
+    }) << std::endl;
+    std::cout << "Quick Sort Time=" << timeSort(nums, [](auto first, auto last){
+        ParallelSort::quickSort(first, last);
+    }) << std::endl;
+
+    //基本有序（1%的随机交换）和大量重复值
+    std::vector<int> nearly_sorted(N), duplicates(N);
+    for(int i = 0; i < N; ++i){
+        nearly_sorted[i] = i;
+        duplicates[i] = (int)(rng() % 5000);
+    }
+    for(int i = 0; i < N / 100; ++i){
+        std::swap(nearly_sorted[rng() % N], nearly_sorted[rng() % N]);
+    }
+    for(auto *v : {&nearly_sorted, &duplicates}){
+        std::cout << (v == &duplicates ? "duplicates:" : "nearly sorted:") << std::endl;
+        std::cout << "  std::sort Time=" << timeSort(*v, [](auto first, auto last){
+            std::sort(first, last);
+        }) << std::endl;
+        std::cout << "  tbb::parallel_sort Time=" << timeSort(*v, [](auto first, auto last){
+            tbb::parallel_sort(first, last);
+        }) << std::endl;
+        std::cout << "  Quick Sort Time=" << timeSort(*v, [](auto first, auto last){
+            ParallelSort::quickSort(first, last);
+        }) << std::endl;
+    }
     return 0;
 }
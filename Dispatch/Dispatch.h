@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+//kernel入口的运行时分发
+//- 每个kernel是一个Kernel<Fn>（Fn是函数指针类型），构造时给出各ISA版本的地址（见DispatchVariant.h的SAMPLES_KERNEL）
+//- 第一次调用时选版本：CPU支持（cpuid）的、已登记的最高ISA；之后直接调用选中的函数指针
+//- 环境变量SAMPLES_ISA=scalar|sse42|avx2|avx512强制使用不高于它的版本，测试各版本时用；
+//  要求的ISA超过CPU支持时仍按CPU支持的选，并打印警告
+namespace Dispatch {
+
+    enum class Isa : int { Scalar = 0, SSE42 = 1, AVX2 = 2, AVX512 = 3 };
+
+    const int NUM_ISAS = 4;
+    const char *const ENV_VAR = "SAMPLES_ISA";
+
+    inline const char *isaName(Isa isa) {
+        static const char *const names[NUM_ISAS] = {"scalar", "sse42", "avx2", "avx512"};
+        return names[(int) isa];
+    }
+
+    //CPU（和操作系统）支持的最高ISA
+    inline Isa detectIsa() {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq")) {
+            return Isa::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi2")) {
+            return Isa::AVX2;
+        }
+        if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+            return Isa::SSE42;
+        }
+#endif
+        return Isa::Scalar;
+    }
+
+    //本进程允许使用的最高ISA：CPU支持的，再按环境变量降低；只算一次
+    inline Isa targetIsa() {
+        static const Isa target = [] {
+            const Isa detected = detectIsa();
+            const char *forced = std::getenv(ENV_VAR);
+            if (forced == nullptr || *forced == 0) {
+                return detected;
+            }
+            for (int i = 0; i < NUM_ISAS; ++i) {
+                if (std::strcmp(forced, isaName((Isa) i)) == 0) {
+                    if (i > (int) detected) {
+                        std::fprintf(stderr, "Warning: %s=%s is not supported by this CPU, using %s\n", ENV_VAR, forced,
+                                     isaName(detected));
+                        return detected;
+                    }
+                    return (Isa) i;
+                }
+            }
+            std::fprintf(stderr, "Warning: unknown %s=%s, using %s\n", ENV_VAR, forced, isaName(detected));
+            return detected;
+        }();
+        return target;
+    }
+
+    //所有kernel的名字和选中的版本，打印用
+    class KernelBase {
+    public:
+        virtual ~KernelBase() = default;
+        virtual const char *name() const = 0;
+        virtual Isa selected() = 0;
+        //已登记的版本，按ISA从低到高
+        virtual std::vector<Isa> registered() const = 0;
+    };
+
+    inline std::vector<KernelBase *> &allKernels() {
+        static std::vector<KernelBase *> kernels;
+        return kernels;
+    }
+
+    template <typename Fn>
+    class Kernel : public KernelBase {
+    public:
+        //variants是各ISA版本的地址；构造时只记下地址，不调用任何版本
+        Kernel(const char *name, std::initializer_list<std::pair<Isa, Fn>> variants) : myName(name) {
+            for (const auto &v : variants) {
+                myVariants[(int) v.first] = v.second;
+            }
+            allKernels().push_back(this);
+        }
+
+        //选中的版本，第一次调用时选定（线程安全）
+        Fn get() {
+            std::call_once(myOnce, [this] {
+                for (int i = (int) targetIsa(); i >= 0; --i) {
+                    if (myVariants[i] != nullptr) {
+                        mySelected = (Isa) i;
+                        break;
+                    }
+                }
+            });
+            return myVariants[(int) mySelected];
+        }
+
+        //指定的版本，没有登记时返回nullptr；用于比较各版本的结果
+        Fn variant(Isa isa) const { return myVariants[(int) isa]; }
+
+        template <typename... Args>
+        auto operator()(Args &&... args) { return get()(std::forward<Args>(args)...); }
+
+        const char *name() const override { return myName; }
+        Isa selected() override {
+            get();
+            return mySelected;
+        }
+        std::vector<Isa> registered() const override {
+            std::vector<Isa> result;
+            for (int i = 0; i < NUM_ISAS; ++i) {
+                if (myVariants[i] != nullptr) {
+                    result.push_back((Isa) i);
+                }
+            }
+            return result;
+        }
+
+    private:
+        const char *myName;
+        Fn myVariants[NUM_ISAS] = {};
+        Isa mySelected = Isa::Scalar;
+        std::once_flag myOnce;
+    };
+
+    //打印CPU支持的ISA和每个kernel选中的版本
+    inline void report(std::ostream &out) {
+        //先选定target，环境变量不对时的警告不会夹在这一行中间
+        const Isa target = targetIsa();
+        out << "cpu: " << isaName(detectIsa()) << ", target: " << isaName(target) << std::endl;
+        for (KernelBase *k : allKernels()) {
+            out << "  " << k->name() << ": " << isaName(k->selected()) << " (";
+            const auto variants = k->registered();
+            for (std::size_t i = 0; i < variants.size(); ++i) {
+                out << (i ? " " : "") << isaName(variants[i]);
+            }
+            out << ")" << std::endl;
+        }
+    }
+
+}
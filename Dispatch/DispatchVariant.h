@@ -0,0 +1,58 @@
+#pragma once
+
+#include <type_traits>
+#include "Dispatch.h"
+
+//kernel的源文件（.cpp）包含这个头文件，它会按ISA编译多次（cmake/IsaVariants.cmake的sample_isa_variants）：
+//- SAMPLES_ISA_NS：本次编译的命名空间（scalar、sse42、avx2、avx512），kernel函数定义在这个命名空间里
+//- 默认编译（没有ISA选项）时是scalar，Kernel对象只在这次编译里构造（SAMPLES_KERNEL）
+//- ISA版本的目标文件里只有kernel函数，没有静态初始化：main之前运行的代码在每台CPU上都会执行，
+//  不能用CPU可能不支持的指令，和链接顺序无关；ISA编译单元不要包含<iostream>（它带一个静态初始化对象）
+//注意：头文件里的inline函数（包括模板）在各ISA编译单元里各生成一份，链接器只留一份，
+//可能留下的是AVX-512版本；kernel里只用本命名空间里的函数、标准库的数学函数和确定会内联的简单操作
+#ifndef SAMPLES_ISA_NS
+#define SAMPLES_ISA_NS scalar
+#define SAMPLES_ISA_LEVEL 0
+#endif
+
+//target里有哪些ISA版本：sample_isa_variants给target定义SAMPLES_ISA_HAVE_<ISA>
+#ifdef SAMPLES_ISA_HAVE_SSE42
+#define SAMPLES_ISA_IF_SSE42(...) __VA_ARGS__
+#else
+#define SAMPLES_ISA_IF_SSE42(...)
+#endif
+#ifdef SAMPLES_ISA_HAVE_AVX2
+#define SAMPLES_ISA_IF_AVX2(...) __VA_ARGS__
+#else
+#define SAMPLES_ISA_IF_AVX2(...)
+#endif
+#ifdef SAMPLES_ISA_HAVE_AVX512
+#define SAMPLES_ISA_IF_AVX512(...) __VA_ARGS__
+#else
+#define SAMPLES_ISA_IF_AVX512(...)
+#endif
+
+#define SAMPLES_ISA_CAT2(a, b) a##b
+#define SAMPLES_ISA_CAT(a, b) SAMPLES_ISA_CAT2(a, b)
+
+//定义kernel的访问函数，写在kernel所在的命名空间里、SAMPLES_ISA_NS之外：
+//  SAMPLES_KERNEL(函数指针类型, 访问函数, "名字", 函数名);
+//默认编译时声明各ISA命名空间里的函数，构造Kernel时只取它们的地址；静态初始化时构造，Dispatch::report()能列出它
+//ISA编译时什么也不生成
+#if SAMPLES_ISA_LEVEL == 0
+#define SAMPLES_KERNEL(Fn, accessor, name, fn) \
+    SAMPLES_ISA_IF_SSE42(namespace sse42 { std::remove_pointer_t<Fn> fn; }) \
+    SAMPLES_ISA_IF_AVX2(namespace avx2 { std::remove_pointer_t<Fn> fn; }) \
+    SAMPLES_ISA_IF_AVX512(namespace avx512 { std::remove_pointer_t<Fn> fn; }) \
+    Dispatch::Kernel<Fn> &accessor() { \
+        static Dispatch::Kernel<Fn> kernel(name, { \
+                {Dispatch::Isa::Scalar, &scalar::fn} \
+                SAMPLES_ISA_IF_SSE42(, {Dispatch::Isa::SSE42, &sse42::fn}) \
+                SAMPLES_ISA_IF_AVX2(, {Dispatch::Isa::AVX2, &avx2::fn}) \
+                SAMPLES_ISA_IF_AVX512(, {Dispatch::Isa::AVX512, &avx512::fn})}); \
+        return kernel; \
+    } \
+    [[maybe_unused]] static Dispatch::Kernel<Fn> &SAMPLES_ISA_CAT(samplesKernel, __LINE__) = accessor()
+#else
+#define SAMPLES_KERNEL(Fn, accessor, name, fn) static_assert(true, "")
+#endif
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <tbb/tbb.h>
+#include "TriangularMatrix.h"
+
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+//分块大小的自动调优：按cache大小和核数选出候选块大小，逐个计时，
+//最好的结果按机器保存在配置文件中，下次直接读取
+namespace Autotune {
+
+    //默认的配置文件，可以用环境变量FS_TUNE_FILE覆盖
+    const char *const DEFAULT_TUNE_FILE = ".forward_substitution_tune";
+    //调优用的矩阵最大阶数，更大的N用这个规模调优，避免调优本身太慢
+    const int MAX_TUNE_N = 8192;
+
+    struct MachineInfo {
+        std::size_t l1 = 32 << 10;
+        std::size_t l2 = 256 << 10;
+        std::size_t l3 = 8 << 20;
+        int cores = 1;
+        std::string host = "unknown";
+
+        //配置文件中的键：主机名 + 核数 + 各级cache大小
+        std::string key() const {
+            std::ostringstream os;
+            os << host << "/c" << cores << "/L1=" << (l1 >> 10) << "K/L2=" << (l2 >> 10)
+               << "K/L3=" << (l3 >> 10) << "K";
+            return os.str();
+        }
+    };
+
+#if defined(__linux__)
+    //读/sys/devices/system/cpu/cpu0/cache/indexN/size，例如"48K"、"2048K"
+    inline std::size_t readSysfsCache(int index) {
+        std::ifstream f("/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/size");
+        std::size_t value = 0;
+        char unit = 0;
+        if (!(f >> value)) {
+            return 0;
+        }
+        f >> unit;
+        if (unit == 'K') value <<= 10;
+        if (unit == 'M') value <<= 20;
+        return value;
+    }
+#endif
+
+    inline MachineInfo detectMachine() {
+        MachineInfo info;
+        info.cores = tbb::info::default_concurrency();
+#if defined(__linux__)
+        //index0是L1数据cache，index1是L1指令cache
+        if (std::size_t v = readSysfsCache(0)) info.l1 = v;
+        if (std::size_t v = readSysfsCache(2)) info.l2 = v;
+        if (std::size_t v = readSysfsCache(3)) info.l3 = v;
+#elif defined(__APPLE__)
+        auto sysctlSize = [](const char *name, std::size_t &out) {
+            std::int64_t v = 0;
+            std::size_t len = sizeof(v);
+            if (sysctlbyname(name, &v, &len, nullptr, 0) == 0 && v > 0) out = (std::size_t) v;
+        };
+        sysctlSize("hw.l1dcachesize", info.l1);
+        sysctlSize("hw.l2cachesize", info.l2);
+        sysctlSize("hw.l3cachesize", info.l3);
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+        char host[256] = {0};
+        if (gethostname(host, sizeof(host) - 1) == 0) {
+            info.host = host;
+        }
+#endif
+        return info;
+    }
+
+    inline std::string tuneFile() {
+        const char *env = std::getenv("FS_TUNE_FILE");
+        return env ? env : DEFAULT_TUNE_FILE;
+    }
+
+    //调优规模按2的幂向下分档（不超过MAX_TUNE_N），同一档共用一个结果
+    inline int tuneSize(int n) {
+        int size = 1;
+        while (size * 2 <= std::min(n, MAX_TUNE_N)) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    //候选块大小：从32开始翻倍，一个非对角块不超过L2的一半或每个核分到的L3的一半，
+    //并且块行数至少是核数的2倍，保证有足够的并行度
+    inline std::vector<int> candidateBlockSizes(int n, const MachineInfo &info) {
+        std::vector<int> candidates;
+        for (int bs = 32; bs <= 4096; bs *= 2) {
+            const std::size_t tile = (std::size_t) bs * bs * sizeof(double);
+            if (tile > std::max(info.l2 / 2, info.l3 / (2 * info.cores))) break;
+            if (bs > n || (bs > 64 && (n + bs - 1) / bs < 2 * info.cores)) break;
+            candidates.push_back(bs);
+        }
+        if (candidates.empty()) {
+            candidates.push_back(std::max(1, std::min(n, 64)));
+        }
+        return candidates;
+    }
+
+    //在n阶问题上逐个计时parallelBlockedFS，每个候选取3次中最快的
+    inline int tuneBlockSize(int n, const MachineInfo &info, bool verbose = true) {
+        std::vector<double> b0(n);
+        for (int i = 0; i < n; ++i) {
+            b0[i] = (double) i * i;
+        }
+        int best_bs = 0;
+        double best_time = 1e300;
+        for (int bs : candidateBlockSizes(n, info)) {
+            Triangular::BlockedLowerMatrix A(n, bs);
+            A.fill([](int i, int j) { return 1.0 + (double) j * i; });
+            double t_min = 1e300;
+            for (int rep = 0; rep < 3; ++rep) {
+                std::vector<double> x(n), b = b0;
+                tbb::tick_count t0 = tbb::tick_count::now();
+                Triangular::parallelBlockedFS(x, A, b);
+                t_min = std::min(t_min, (tbb::tick_count::now() - t0).seconds());
+            }
+            if (verbose) {
+                std::cout << "  autotune n=" << n << " block_size=" << bs << " : " << t_min << " seconds" << std::endl;
+            }
+            if (t_min < best_time) {
+                best_time = t_min;
+                best_bs = bs;
+            }
+        }
+        return best_bs;
+    }
+
+    //块大小的合法范围：1 <= bs <= n
+    inline bool validBlockSize(int bs, int n) { return bs >= 1 && bs <= n; }
+
+    //配置文件每行："机器键 n 块大小"；块大小不合法（文件被改坏）的行跳过
+    inline int loadBlockSize(const std::string &path, const std::string &key, int n) {
+        std::ifstream f(path);
+        std::string k;
+        int file_n, bs;
+        while (f >> k >> file_n >> bs) {
+            if (k == key && file_n == n) {
+                if (validBlockSize(bs, n)) {
+                    return bs;
+                }
+                std::cerr << "Warning: ignoring block size " << bs << " for n=" << n << " in " << path << std::endl;
+            }
+        }
+        return 0;
+    }
+
+    inline void saveBlockSize(const std::string &path, const std::string &key, int n, int bs) {
+        std::ofstream f(path, std::ios::app);
+        if (!f) {
+            std::cerr << "Warning: cannot write " << path << std::endl;
+            return;
+        }
+        f << key << " " << n << " " << bs << std::endl;
+    }
+
+    //求N阶问题的块大小：本机有保存的结果就直接用，否则调优并保存
+    inline int bestBlockSize(int n) {
+        const MachineInfo info = detectMachine();
+        const std::string path = tuneFile();
+        const int n_tune = tuneSize(n);
+        if (int bs = loadBlockSize(path, info.key(), n_tune)) {
+            return bs;
+        }
+        std::cout << "autotuning block size for " << info.key() << std::endl;
+        int bs = tuneBlockSize(n_tune, info);
+        saveBlockSize(path, info.key(), n_tune, bs);
+        return bs;
+    }
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <tbb/tbb.h>
+#include "TriangularMatrix.h"
+
+//混合精度前代：矩阵按低精度（float或bf16）存储做分块并行前代，
+//再用double精度的残差做迭代修正，直到相对残差小于给定的容差
+//前代是访存受限的，矩阵字节数减半（float）或减到1/4（bf16），低精度求解也相应变快
+namespace Mixed {
+
+    //CPU上模拟的bf16：float的高16位（1位符号、8位指数、7位尾数）
+    //指数范围与float相同，只是尾数短，转成float只需左移16位
+    struct BFloat16 {
+        std::uint16_t bits = 0;
+
+        BFloat16() = default;
+        //就近舍入到偶数，NaN保持为NaN
+        explicit BFloat16(float f) {
+            std::uint32_t u;
+            std::memcpy(&u, &f, sizeof(u));
+            if ((u & 0x7fffffffu) > 0x7f800000u) {
+                bits = (std::uint16_t) ((u >> 16) | 0x40u);
+            } else {
+                u += 0x7fffu + ((u >> 16) & 1u);
+                bits = (std::uint16_t) (u >> 16);
+            }
+        }
+        explicit BFloat16(double d) : BFloat16((float) d) {}
+
+        operator float() const {
+            std::uint32_t u = (std::uint32_t) bits << 16;
+            float f;
+            std::memcpy(&f, &u, sizeof(f));
+            return f;
+        }
+    };
+
+    //把double矩阵并行转换成低精度存储，块布局相同，逐元素对应
+    template <typename Low>
+    Triangular::BasicBlockedLowerMatrix<Low> convert(const Triangular::BlockedLowerMatrix &A) {
+        Triangular::BasicBlockedLowerMatrix<Low> low(A.size(), A.blockSize());
+        const double *src = A.data();
+        Low *dst = low.data();
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, A.elements()), [=](const tbb::blocked_range<std::size_t> &r) {
+            for (std::size_t k = r.begin(); k != r.end(); ++k) {
+                dst[k] = Low(src[k]);
+            }
+        });
+        return low;
+    }
+
+    //r = b - A * x，各块行互不依赖，完全并行（与前代不同，没有关键路径）
+    //对角块的上三角部分存的是0，可以当成普通的满块做GEMV
+    inline void residual(const Triangular::BlockedLowerMatrix &A, const std::vector<double> &x,
+                         const std::vector<double> &b, std::vector<double> &r) {
+        tbb::parallel_for(0, A.numBlocks(), [&](int rb) {
+            const int i0 = A.blockStart(rb), rows = A.blockRows(rb);
+            std::copy(b.begin() + i0, b.begin() + i0 + rows, r.begin() + i0);
+            for (int c = 0; c <= rb; ++c) {
+                const int cols = A.blockCols(rb, c);
+                Triangular::gemvUpdate(A.block(rb, c), rows, cols, cols, x.data() + A.blockStart(c), r.data() + i0);
+            }
+        });
+    }
+
+    inline double normInf(const std::vector<double> &v) {
+        return tbb::parallel_reduce(tbb::blocked_range<std::size_t>(0, v.size()), 0.0,
+                                    [&](const tbb::blocked_range<std::size_t> &r, double m) {
+                                        for (std::size_t i = r.begin(); i != r.end(); ++i) {
+                                            m = std::max(m, std::abs(v[i]));
+                                        }
+                                        return m;
+                                    },
+                                    [](double a, double b) { return std::max(a, b); });
+    }
+
+    //矩阵的无穷范数（最大行和）
+    inline double normInf(const Triangular::BlockedLowerMatrix &A) {
+        std::vector<double> row_sum(A.size());
+        tbb::parallel_for(0, A.numBlocks(), [&](int rb) {
+            const int i0 = A.blockStart(rb);
+            for (int c = 0; c <= rb; ++c) {
+                const double *blk = A.block(rb, c);
+                const int cols = A.blockCols(rb, c);
+                for (int i = 0; i < A.blockRows(rb); ++i) {
+                    for (int j = 0; j < cols; ++j) {
+                        row_sum[i0 + i] += std::abs(blk[(std::size_t) i * cols + j]);
+                    }
+                }
+            }
+        });
+        return normInf(row_sum);
+    }
+
+    //相对残差（按范数的后向误差）：||b - Ax|| / (||A|| ||x|| + ||b||)
+    inline double relativeResidual(const Triangular::BlockedLowerMatrix &A, double norm_a,
+                                   const std::vector<double> &x, const std::vector<double> &b) {
+        std::vector<double> r(b.size());
+        residual(A, x, b, r);
+        return normInf(r) / (norm_a * normInf(x) + normInf(b));
+    }
+
+    struct RefineResult {
+        int iterations = 0;         //低精度求解的次数
+        double residual = 0;        //最终的相对残差
+        bool converged = false;
+    };
+
+    //迭代修正：x_0 = 0，r_k = b - A x_k（double），低精度求解 A_low d = r_k，x_{k+1} = x_k + d
+    //收敛要求cond(A) * 低精度的单位舍入 < 1，不满足时最多迭代max_iterations次
+    template <typename Low>
+    RefineResult refine(std::vector<double> &x, const Triangular::BlockedLowerMatrix &A,
+                        const Triangular::BasicBlockedLowerMatrix<Low> &A_low, const std::vector<double> &b,
+                        double tolerance, int max_iterations = 30) {
+        const int n = A.size();
+        const double norm_a = normInf(A), norm_b = normInf(b);
+        std::vector<double> r = b, d(n);
+        std::fill(x.begin(), x.end(), 0.0);
+        RefineResult result;
+        for (int it = 0; it < max_iterations; ++it) {
+            //parallelBlockedFS会改写右端项，r下一轮重新算
+            Triangular::parallelBlockedFS(d, A_low, r);
+            tbb::parallel_for(0, n, [&](int i) { x[i] += d[i]; });
+            ++result.iterations;
+            residual(A, x, b, r);
+            result.residual = normInf(r) / (norm_a * normInf(x) + norm_b);
+            if (result.residual <= tolerance) {
+                result.converged = true;
+                break;
+            }
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <tbb/tbb.h>
+
+//CSR存储的稀疏下三角前代，按层（level set）并行
+//分析阶段求出每行所在的层：第i行的层 = 1 + 它依赖的各行（同一行中j < i的非零元）的最大层，
+//同一层的行互不依赖，求解时逐层parallel_for
+//分析结果只依赖稀疏结构，结构不变时反复求解（值可以变）不需要重新分析
+namespace Sparse {
+
+    //层内行数少于该值时串行，避免parallel_for的调度开销超过计算本身
+    const int MIN_PARALLEL_ROWS = 256;
+
+    //新的稀疏结构编号，从1开始，0表示没有编号
+    inline std::uint64_t nextPatternId() {
+        static std::atomic<std::uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //CSR下三角矩阵：每行的列号j <= i，必须包含对角元
+    //填好或修改row_ptr、col_idx后调用patternChanged()，结构换一个新编号，SolverCache据此O(1)判断结构是否变了；
+    //只改values不用调用。拷贝矩阵时编号一起拷贝（结构相同）
+    struct CsrMatrix {
+        int n = 0;
+        std::vector<int> row_ptr;   //n + 1
+        std::vector<int> col_idx;   //nnz
+        std::vector<double> values; //nnz
+        std::uint64_t pattern_id = 0;
+
+        int nnz() const { return (int) col_idx.size(); }
+        void patternChanged() { pattern_id = nextPatternId(); }
+    };
+
+    class LowerSolver {
+    public:
+        //分析阶段
+        explicit LowerSolver(const CsrMatrix &L)
+                : myN(L.n), myPatternId(L.pattern_id), myRowPtr(L.row_ptr), myColIdx(L.col_idx) {
+            myDiag.resize(myN);
+            std::vector<int> level(myN, 0);
+            int num_levels = 0;
+            for (int i = 0; i < myN; ++i) {
+                int lv = 0;
+                myDiag[i] = -1;
+                for (int k = L.row_ptr[i]; k < L.row_ptr[i + 1]; ++k) {
+                    int j = L.col_idx[k];
+                    if (j == i) {
+                        myDiag[i] = k;
+                    } else {
+                        lv = std::max(lv, level[j] + 1);
+                    }
+                }
+                level[i] = lv;
+                num_levels = std::max(num_levels, lv + 1);
+            }
+
+            //按层分组（计数排序），层内保持行号递增，访存更连续
+            myLevelPtr.assign(num_levels + 1, 0);
+            for (int i = 0; i < myN; ++i) {
+                ++myLevelPtr[level[i] + 1];
+            }
+            for (int l = 0; l < num_levels; ++l) {
+                myLevelPtr[l + 1] += myLevelPtr[l];
+            }
+            myLevelRows.resize(myN);
+            std::vector<int> pos(myLevelPtr.begin(), myLevelPtr.end() - 1);
+            for (int i = 0; i < myN; ++i) {
+                myLevelRows[pos[level[i]]++] = i;
+            }
+        }
+
+        int numLevels() const { return (int) myLevelPtr.size() - 1; }
+        bool valid() const { return std::find(myDiag.begin(), myDiag.end(), -1) == myDiag.end(); }
+
+        //稀疏结构是否和分析时相同，相同就可以复用本对象
+        //有编号时只比较编号；没有编号（pattern_id为0）时逐个比较结构，O(nnz)
+        bool matches(const CsrMatrix &L) const {
+            if (L.n != myN || L.nnz() != (int) myColIdx.size()) {
+                return false;
+            }
+            if (L.pattern_id != 0 || myPatternId != 0) {
+                return L.pattern_id == myPatternId;
+            }
+            return L.row_ptr == myRowPtr && L.col_idx == myColIdx;
+        }
+
+        //求解阶段：values是与分析时相同结构的非零元
+        void solve(const std::vector<double> &values, const std::vector<double> &b, std::vector<double> &x) const {
+            for (int l = 0; l < numLevels(); ++l) {
+                const int begin = myLevelPtr[l], end = myLevelPtr[l + 1];
+                if (end - begin < MIN_PARALLEL_ROWS) {
+                    for (int k = begin; k < end; ++k) {
+                        solveRow(myLevelRows[k], values, b, x);
+                    }
+                } else {
+                    tbb::parallel_for(tbb::blocked_range<int>(begin, end, MIN_PARALLEL_ROWS / 4),
+                                      [&](const tbb::blocked_range<int> &r) {
+                                          for (int k = r.begin(); k != r.end(); ++k) {
+                                              solveRow(myLevelRows[k], values, b, x);
+                                          }
+                                      });
+                }
+            }
+        }
+
+        //串行求解，作为对照
+        void serialSolve(const std::vector<double> &values, const std::vector<double> &b, std::vector<double> &x) const {
+            for (int i = 0; i < myN; ++i) {
+                solveRow(i, values, b, x);
+            }
+        }
+
+    private:
+        void solveRow(int i, const std::vector<double> &values, const std::vector<double> &b, std::vector<double> &x) const {
+            double sum = b[i];
+            for (int k = myRowPtr[i]; k < myRowPtr[i + 1]; ++k) {
+                if (k != myDiag[i]) {
+                    sum -= values[k] * x[myColIdx[k]];
+                }
+            }
+            x[i] = sum / values[myDiag[i]];
+        }
+
+        int myN;
+        std::uint64_t myPatternId;
+        std::vector<int> myRowPtr;
+        std::vector<int> myColIdx;
+        std::vector<int> myDiag;        //每行对角元在col_idx中的位置
+        std::vector<int> myLevelPtr;    //第l层的行是myLevelRows[myLevelPtr[l], myLevelPtr[l+1])
+        std::vector<int> myLevelRows;
+    };
+
+    //按结构缓存分析结果：结构相同直接返回上次的LowerSolver，否则重新分析
+    //矩阵有结构编号时命中的判断是O(1)的；也可以直接保留LowerSolver，不经过缓存
+    class SolverCache {
+    public:
+        const LowerSolver &get(const CsrMatrix &L) {
+            if (!mySolver || !mySolver->matches(L)) {
+                mySolver = std::make_unique<LowerSolver>(L);
+            }
+            return *mySolver;
+        }
+
+    private:
+        std::unique_ptr<LowerSolver> mySolver;
+    };
+
+}
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <tbb/tbb.h>
+#include "Wavefront.h"
+
+//分块存储的下三角矩阵和分块前代求解核
+namespace Triangular {
+
+    //内层循环每个累加器的宽度（4个double = 一个AVX寄存器）
+    const int LANES = 4;
+
+    //分块下三角矩阵，只存c <= r的块，约为稠密存储的一半
+    //每块按行主序连续存放，同一块行的各块首尾相接：
+    //[ (0,0) ][ (1,0) (1,1) ][ (2,0) (2,1) (2,2) ] ...
+    //非对角块是block_size x block_size，对角块是rows x rows（上三角部分是0）
+    //N不是block_size整数倍时，最后一个块行只有N % block_size行
+    //元素类型T默认double，低精度存储（float、bf16）见MixedPrecision.h
+    template <typename T>
+    class BasicBlockedLowerMatrix {
+    public:
+        using value_type = T;
+
+        BasicBlockedLowerMatrix(int n, int block_size) : myN(n), myBlockSize(block_size) {
+            myNumBlocks = (n + block_size - 1) / block_size;
+            myRowOffset.resize(myNumBlocks + 1);
+            std::size_t offset = 0;
+            for (int r = 0; r < myNumBlocks; ++r) {
+                myRowOffset[r] = offset;
+                offset += (std::size_t) blockRows(r) * (r * block_size + blockRows(r));
+            }
+            myRowOffset[myNumBlocks] = offset;
+            myData.resize(offset);
+        }
+
+        int size() const { return myN; }
+        int blockSize() const { return myBlockSize; }
+        int numBlocks() const { return myNumBlocks; }
+        int blockStart(int r) const { return r * myBlockSize; }
+        int blockRows(int r) const { return std::min(myBlockSize, myN - r * myBlockSize); }
+        //块(r, c)的列数，也是它的行跨度
+        int blockCols(int r, int c) const { return c < r ? myBlockSize : blockRows(r); }
+
+        T *block(int r, int c) {
+            return &myData[myRowOffset[r] + (std::size_t) c * blockRows(r) * myBlockSize];
+        }
+        const T *block(int r, int c) const {
+            return &myData[myRowOffset[r] + (std::size_t) c * blockRows(r) * myBlockSize];
+        }
+
+        //元素(i, j)，要求j <= i
+        T &at(int i, int j) {
+            int r = i / myBlockSize, c = j / myBlockSize;
+            return block(r, c)[(i - blockStart(r)) * blockCols(r, c) + (j - blockStart(c))];
+        }
+        T at(int i, int j) const {
+            int r = i / myBlockSize, c = j / myBlockSize;
+            return block(r, c)[(i - blockStart(r)) * blockCols(r, c) + (j - blockStart(c))];
+        }
+
+        //按f(i, j)并行填充下三角部分
+        template <typename F>
+        void fill(F f) {
+            tbb::parallel_for(0, myNumBlocks, [this, &f](int r) {
+                for (int c = 0; c <= r; ++c) {
+                    T *blk = block(r, c);
+                    const int rows = blockRows(r), cols = blockCols(r, c);
+                    for (int i = 0; i < rows; ++i) {
+                        for (int j = 0; j < cols; ++j) {
+                            int gi = blockStart(r) + i, gj = blockStart(c) + j;
+                            blk[i * cols + j] = T((gj <= gi) ? f(gi, gj) : 0.0);
+                        }
+                    }
+                }
+            });
+        }
+
+        //整块存储，块布局只由n和block_size决定，不同元素类型的矩阵可以逐元素对应
+        T *data() { return myData.data(); }
+        const T *data() const { return myData.data(); }
+        std::size_t elements() const { return myData.size(); }
+        std::size_t bytes() const { return myData.size() * sizeof(T); }
+
+    private:
+        int myN;
+        int myBlockSize;
+        int myNumBlocks;
+        std::vector<std::size_t> myRowOffset;
+        std::vector<T, tbb::cache_aligned_allocator<T>> myData;
+    };
+
+    using BlockedLowerMatrix = BasicBlockedLowerMatrix<double>;
+
+    //点积，LANES x 2个独立的累加器，打断浮点加法的依赖链，便于向量化
+    //矩阵元素T可以是低精度类型，读入后转成double累加
+    template <typename T>
+    inline double dot(const T *a, const double *x, int n) {
+        double s0[LANES] = {0}, s1[LANES] = {0};
+        int j = 0;
+        for (; j + 2 * LANES <= n; j += 2 * LANES) {
+            for (int l = 0; l < LANES; ++l) {
+                s0[l] += double(a[j + l]) * x[j + l];
+                s1[l] += double(a[j + LANES + l]) * x[j + LANES + l];
+            }
+        }
+        double sum = 0;
+        for (int l = 0; l < LANES; ++l) {
+            sum += s0[l] + s1[l];
+        }
+        for (; j < n; ++j) {
+            sum += double(a[j]) * x[j];
+        }
+        return sum;
+    }
+
+    //非对角块：b[0, rows) -= A * x，A是rows x cols、行跨度lda的行主序块
+    //每次处理4行，x的每个元素读一次用4次，每行LANES个累加器
+    template <typename T>
+    inline void gemvUpdate(const T *A, int rows, int cols, int lda, const double *x, double *b) {
+        int i = 0;
+        for (; i + 4 <= rows; i += 4) {
+            const T *a0 = A + (std::size_t) i * lda;
+            const T *a1 = a0 + lda, *a2 = a1 + lda, *a3 = a2 + lda;
+            double s0[LANES] = {0}, s1[LANES] = {0}, s2[LANES] = {0}, s3[LANES] = {0};
+            int j = 0;
+            for (; j + LANES <= cols; j += LANES) {
+                for (int l = 0; l < LANES; ++l) {
+                    const double xv = x[j + l];
+                    s0[l] += double(a0[j + l]) * xv;
+                    s1[l] += double(a1[j + l]) * xv;
+                    s2[l] += double(a2[j + l]) * xv;
+                    s3[l] += double(a3[j + l]) * xv;
+                }
+            }
+            double t0 = 0, t1 = 0, t2 = 0, t3 = 0;
+            for (int l = 0; l < LANES; ++l) {
+                t0 += s0[l];
+                t1 += s1[l];
+                t2 += s2[l];
+                t3 += s3[l];
+            }
+            for (; j < cols; ++j) {
+                t0 += double(a0[j]) * x[j];
+                t1 += double(a1[j]) * x[j];
+                t2 += double(a2[j]) * x[j];
+                t3 += double(a3[j]) * x[j];
+            }
+            b[i] -= t0;
+            b[i + 1] -= t1;
+            b[i + 2] -= t2;
+            b[i + 3] -= t3;
+        }
+        for (; i < rows; ++i) {
+            b[i] -= dot(A + (std::size_t) i * lda, x, cols);
+        }
+    }
+
+    //对角块：n x n下三角块上的前代，行跨度ldd
+    template <typename T>
+    inline void trsvLower(const T *D, int n, int ldd, double *b, double *x) {
+        for (int i = 0; i < n; ++i) {
+            const T *row = D + (std::size_t) i * ldd;
+            b[i] -= dot(row, x, i);
+            x[i] = b[i] / double(row[i]);
+        }
+    }
+
+    //块(r, c)的计算：非对角块做GEMV更新，对角块做TRSV
+    template <typename T>
+    inline void blockKernel(const BasicBlockedLowerMatrix<T> &A, int r, int c, double *x, double *b) {
+        const int i0 = A.blockStart(r), j0 = A.blockStart(c);
+        const int rows = A.blockRows(r), cols = A.blockCols(r, c);
+        if (c < r) {
+            gemvUpdate(A.block(r, c), rows, cols, cols, x + j0, b + i0);
+        } else {
+            trsvLower(A.block(r, c), rows, cols, b + i0, x + i0);
+        }
+    }
+
+    //串行分块前代
+    template <typename T>
+    inline void serialBlockedFS(std::vector<double> &x, const BasicBlockedLowerMatrix<T> &A, std::vector<double> &b) {
+        for (int r = 0; r < A.numBlocks(); ++r) {
+            for (int c = 0; c <= r; ++c) {
+                blockKernel(A, r, c, x.data(), b.data());
+            }
+        }
+    }
+
+    //并行分块前代，按块依赖由Wavefront执行器调度
+    template <typename T>
+    inline void parallelBlockedFS(std::vector<double> &x, const BasicBlockedLowerMatrix<T> &A, std::vector<double> &b) {
+        Wavefront::lowerTriangular(A.numBlocks(), [&](int r, int c) {
+            blockKernel(A, r, c, x.data(), b.data());
+        });
+    }
+
+
+    //多右端项的列分组宽度：X、B各一个block_size x RHS_PANEL的块能留在L2里
+    const int RHS_PANEL = 32;
+
+    //多右端项的非对角块：B[rows x p] -= A[rows x cols] * X[cols x p]
+    //B、X行主序，行跨度ldb；A的每个元素读一次，用在p个右端项上
+    //每次处理A的4行，X的一行读一次更新B的4行
+    inline void gemmUpdate(const double *A, int rows, int cols, int lda,
+                           const double *X, double *B, int p, int ldb) {
+        int i = 0;
+        for (; i + 4 <= rows; i += 4) {
+            const double *a0 = A + (std::size_t) i * lda;
+            const double *a1 = a0 + lda, *a2 = a1 + lda, *a3 = a2 + lda;
+            double *b0 = B + (std::size_t) i * ldb;
+            double *b1 = b0 + ldb, *b2 = b1 + ldb, *b3 = b2 + ldb;
+            for (int j = 0; j < cols; ++j) {
+                const double *x_row = X + (std::size_t) j * ldb;
+                const double v0 = a0[j], v1 = a1[j], v2 = a2[j], v3 = a3[j];
+                for (int k = 0; k < p; ++k) {
+                    const double xv = x_row[k];
+                    b0[k] -= v0 * xv;
+                    b1[k] -= v1 * xv;
+                    b2[k] -= v2 * xv;
+                    b3[k] -= v3 * xv;
+                }
+            }
+        }
+        for (; i < rows; ++i) {
+            const double *a_row = A + (std::size_t) i * lda;
+            double *b_row = B + (std::size_t) i * ldb;
+            for (int j = 0; j < cols; ++j) {
+                const double a = a_row[j];
+                const double *x_row = X + (std::size_t) j * ldb;
+                for (int k = 0; k < p; ++k) {
+                    b_row[k] -= a * x_row[k];
+                }
+            }
+        }
+    }
+
+    //多右端项的对角块
+    inline void trsmLower(const double *D, int n, int ldd, double *B, double *X, int p, int ldb) {
+        for (int i = 0; i < n; ++i) {
+            const double *d_row = D + (std::size_t) i * ldd;
+            double *b_row = B + (std::size_t) i * ldb;
+            for (int j = 0; j < i; ++j) {
+                const double a = d_row[j];
+                const double *x_row = X + (std::size_t) j * ldb;
+                for (int k = 0; k < p; ++k) {
+                    b_row[k] -= a * x_row[k];
+                }
+            }
+            const double inv = 1.0 / d_row[i];
+            double *x_out = X + (std::size_t) i * ldb;
+            for (int k = 0; k < p; ++k) {
+                x_out[k] = b_row[k] * inv;
+            }
+        }
+    }
+
+    //块(r, c)在右端项列[k0, k0 + p)上的计算
+    inline void blockKernelRhs(const BlockedLowerMatrix &A, int r, int c, double *X, double *B,
+                               int k0, int p, int nrhs) {
+        const int i0 = A.blockStart(r), j0 = A.blockStart(c);
+        const int rows = A.blockRows(r), cols = A.blockCols(r, c);
+        double *b = B + (std::size_t) i0 * nrhs + k0;
+        if (c < r) {
+            gemmUpdate(A.block(r, c), rows, cols, cols, X + (std::size_t) j0 * nrhs + k0, b, p, nrhs);
+        } else {
+            trsmLower(A.block(r, c), rows, cols, b, X + (std::size_t) i0 * nrhs + k0, p, nrhs);
+        }
+    }
+
+    //串行多右端项前代（TRSM）：X、B是N x nrhs的行主序矩阵，每列是一个右端项
+    inline void serialBlockedTRSM(std::vector<double> &X, const BlockedLowerMatrix &A, std::vector<double> &B,
+                                  int nrhs, int panel = RHS_PANEL) {
+        for (int k0 = 0; k0 < nrhs; k0 += panel) {
+            const int p = std::min(panel, nrhs - k0);
+            for (int r = 0; r < A.numBlocks(); ++r) {
+                for (int c = 0; c <= r; ++c) {
+                    blockKernelRhs(A, r, c, X.data(), B.data(), k0, p, nrhs);
+                }
+            }
+        }
+    }
+
+    //并行多右端项前代：各列组之间互不依赖并行，每个列组内部按块依赖并行
+    inline void parallelBlockedTRSM(std::vector<double> &X, const BlockedLowerMatrix &A, std::vector<double> &B,
+                                    int nrhs, int panel = RHS_PANEL) {
+        const int num_panels = (nrhs + panel - 1) / panel;
+        tbb::parallel_for(0, num_panels, [&](int k) {
+            const int k0 = k * panel, p = std::min(panel, nrhs - k0);
+            Wavefront::lowerTriangular(A.numBlocks(), [&](int r, int c) {
+                blockKernelRhs(A, r, c, X.data(), B.data(), k0, p, nrhs);
+            });
+        });
+    }
+
+}
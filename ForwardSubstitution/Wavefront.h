@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <tbb/tbb.h>
+
+//二维块依赖问题（前代、各种波前stencil）的通用DAG执行器
+//不建flow graph：每个块一个补齐到cache line的原子计数器，
+//一个块完成后把就绪的后继直接作为任务启动
+namespace Wavefront {
+
+    //C++17后，可以用std::hardware_destructive_interference_size替代64
+    const std::size_t CACHE_LINE = 64;
+
+    //补齐到一条cache line的依赖计数器，相邻块的计数器不会伪共享
+    struct alignas(CACHE_LINE) PaddedCounter {
+        std::atomic<int> value{0};
+    };
+
+    struct Cell {
+        int r, c;
+    };
+
+    //num_preds(r, c)：块的前驱个数，< 0表示该块不存在（例如三角形区域之外）
+    //successors(r, c, visit)：对(r, c)的每个后继调用visit(r2, c2)
+    //priority(r, c)：越大越优先，用来让关键路径上的块先执行
+    //body(r, c)：块的计算
+    template <typename NumPreds, typename Successors, typename Priority, typename Body>
+    class Executor {
+    public:
+        Executor(int rows, int cols, NumPreds num_preds, Successors successors, Priority priority, Body body)
+                : myRows(rows), myCols(cols), myCounters((std::size_t) rows * cols),
+                  myNumPreds(num_preds), mySuccessors(successors), myPriority(priority), myBody(body) {}
+
+        void run() {
+            std::vector<Cell> roots;
+            for (int r = 0; r < myRows; ++r) {
+                for (int c = 0; c < myCols; ++c) {
+                    int preds = myNumPreds(r, c);
+                    myCounters[index(r, c)].value.store(preds, std::memory_order_relaxed);
+                    if (preds == 0) {
+                        roots.push_back(Cell{r, c});
+                    }
+                }
+            }
+            for (Cell cell : roots) {
+                myTasks.run([this, cell]() { process(cell); });
+            }
+            myTasks.wait();
+        }
+
+    private:
+        std::size_t index(int r, int c) const { return (std::size_t) r * myCols + c; }
+
+        //执行一个块；就绪的后继中优先级最高的由当前线程接着执行（不入队、不递归），其余作为新任务
+        void process(Cell cell) {
+            std::vector<Cell> ready;
+            while (true) {
+                myBody(cell.r, cell.c);
+                ready.clear();
+                mySuccessors(cell.r, cell.c, [this, &ready](int r, int c) {
+                    if (myCounters[index(r, c)].value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        ready.push_back(Cell{r, c});
+                    }
+                });
+                if (ready.empty()) {
+                    return;
+                }
+                std::size_t best = 0;
+                for (std::size_t i = 1; i < ready.size(); ++i) {
+                    if (myPriority(ready[i].r, ready[i].c) > myPriority(ready[best].r, ready[best].c)) {
+                        best = i;
+                    }
+                }
+                for (std::size_t i = 0; i < ready.size(); ++i) {
+                    if (i != best) {
+                        Cell next = ready[i];
+                        myTasks.run([this, next]() { process(next); });
+                    }
+                }
+                cell = ready[best];
+            }
+        }
+
+        int myRows;
+        int myCols;
+        std::vector<PaddedCounter, tbb::cache_aligned_allocator<PaddedCounter>> myCounters;
+        NumPreds myNumPreds;
+        Successors mySuccessors;
+        Priority myPriority;
+        Body myBody;
+        tbb::task_group myTasks;
+    };
+
+    template <typename NumPreds, typename Successors, typename Priority, typename Body>
+    void execute(int rows, int cols, NumPreds num_preds, Successors successors, Priority priority, Body body) {
+        Executor<NumPreds, Successors, Priority, Body> executor(rows, cols, num_preds, successors, priority, body);
+        executor.run();
+    }
+
+    //经典二维波前：(r, c)依赖(r-1, c)和(r, c-1)，按反对角线推进
+    template <typename Body>
+    void wavefront2D(int rows, int cols, Body body) {
+        execute(rows, cols,
+                [](int r, int c) { return (r > 0) + (c > 0); },
+                [rows, cols](int r, int c, auto visit) {
+                    if (r + 1 < rows) visit(r + 1, c);
+                    if (c + 1 < cols) visit(r, c + 1);
+                },
+                //剩余路径越长越优先
+                [rows, cols](int r, int c) { return (rows - r) + (cols - c); },
+                body);
+    }
+
+    //下三角块前代的依赖：
+    //非对角块(r, c)需要x_c，即对角块(c, c)完成；同一块行对b_r的更新串行，即(r, c-1)完成
+    //对角块(r, r)需要本块行的所有更新完成，即(r, r-1)完成
+    //关键路径沿对角线 (c, c) -> (c+1, c) -> (c+1, c+1) -> ...，离对角线越近越优先
+    template <typename Body>
+    void lowerTriangular(int num_blocks, Body body) {
+        execute(num_blocks, num_blocks,
+                [](int r, int c) {
+                    if (c > r) return -1;
+                    if (r == 0 && c == 0) return 0;
+                    if (c == 0 || r == c) return 1;
+                    return 2;
+                },
+                [num_blocks](int r, int c, auto visit) {
+                    if (r == c) {
+                        for (int r2 = r + 1; r2 < num_blocks; ++r2) {
+                            visit(r2, c);
+                        }
+                    } else {
+                        visit(r, c + 1);
+                    }
+                },
+                [num_blocks](int r, int c) { return -(r - c) * num_blocks - r; },
+                body);
+    }
+
+}
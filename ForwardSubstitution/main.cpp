@@ -1,6 +1,16 @@
 #include <iostream>
 #include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 #include <tbb/tbb.h>
+#include "TriangularMatrix.h"
+#include "Wavefront.h"
+#include "Autotune.h"
+#include "SparseTriangular.h"
+#include "MixedPrecision.h"
 
 //串行
 void serialFS(std::vector<double> &x, const std::vector<double> &a, std::vector<double> &b) {
@@ -14,15 +24,15 @@ void serialFS(std::vector<double> &x, const std::vector<double> &a, std::vector<
 }
 
 //串型+分块
-void serialBlockFS(std::vector<double> &x, const std::vector<double> &a, std::vector<double> &b) {
+void serialBlockFS(std::vector<double> &x, const std::vector<double> &a, std::vector<double> &b, int block_size) {
     const int N = x.size();
-    const int block_size = 512;
-    const int num_blocks = N / block_size;
+    //最后一个块可能不满
+    const int num_blocks = (N + block_size - 1) / block_size;
 
     for (int r = 0; r < num_blocks; ++r) {
         for (int c = 0; c <= r; ++c) {
-            int i_start = r * block_size, i_end = i_start + block_size;
-            int j_start = c * block_size, j_max = j_start + block_size - 1;
+            int i_start = r * block_size, i_end = std::min(i_start + block_size, N);
+            int j_start = c * block_size, j_max = std::min(j_start + block_size, N) - 1;
             for (int i = i_start; i < i_end; ++i) {
                 int j_end = (i <= j_max) ? i : j_max + 1;
                 for (int j = j_start; j < j_end; ++j) {
@@ -36,87 +46,30 @@ void serialBlockFS(std::vector<double> &x, const std::vector<double> &a, std::ve
     }
 }
 
-//并行
-void parallelFS(std::vector<double> &x, const std::vector<double> &a, std::vector<double> &b) {
+//并行，块依赖交给Wavefront执行器：每块一个独立cache line的计数器，后继就绪后直接作为任务启动
+void parallelFS(std::vector<double> &x, const std::vector<double> &a, std::vector<double> &b, int block_size) {
     const int N = x.size();
-    const int block_size = 512;
-    const int num_blocks = N / block_size;
-    //tbb::atomic已经废弃
-    std::vector<std::atomic<char>> ref_count(num_blocks * num_blocks);
-    for (int r = 0; r < num_blocks; ++r) {
-        for (int c = 0; c <= r; ++c) {
-            if (r == 0 && c == 0)
-                ref_count[r * num_blocks + c] = 0;
-            else if (c == 0 || r == c)
-                ref_count[r * num_blocks + c] = 1;
-            else
-                ref_count[r * num_blocks + c] = 2;
-        }
-    }
+    //最后一个块可能不满
+    const int num_blocks = (N + block_size - 1) / block_size;
 
-    using BlockIndex = std::pair<size_t, size_t>;
-    BlockIndex top_left(0, 0);
-    //tbb::parallel_do已经废弃
-    tbb::parallel_for_each(&top_left, &top_left + 1,
-                           [&](const BlockIndex &bi, tbb::feeder<BlockIndex> &feeder) {
-                               size_t r = bi.first;
-                               size_t c = bi.second;
-                               int i_start = r * block_size, i_end = i_start + block_size;
-                               int j_start = c * block_size, j_max = j_start + block_size - 1;
-                               for (int i = i_start; i < i_end; ++i) {
-                                   int j_end = (i <= j_max) ? i : j_max + 1;
-                                   for (int j = j_start; j < j_end; ++j) {
-                                       b[i] -= a[j + i * N] * x[j];
-                                   }
-                                   if (j_end == i) {
-                                       x[i] = b[i] / a[i + i * N];
-                                   }
-                               }
-                               // add successor to right if ready
-                               if (c + 1 <= r && --ref_count[r * num_blocks + c + 1] == 0) {
-                                   feeder.add(BlockIndex(r, c + 1));
-                               }
-                               // add succesor below if ready
-                               if (r + 1 < (size_t) num_blocks && --ref_count[(r + 1) * num_blocks + c] == 0) {
-                                   feeder.add(BlockIndex(r + 1, c));
-                               }
-                           }
-    );
-}
-
-//独立图
-using Node = tbb::flow::continue_node<tbb::flow::continue_msg>;
-using NodePtr = std::shared_ptr<Node>;
-NodePtr createNode(tbb::flow::graph &g, int r, int c, int block_size,
-                   std::vector<double> &x, const std::vector<double> &a, std::vector<double> &b);
-void addEdges(std::vector<NodePtr> &nodes, int r, int c, int block_size, int num_blocks);
-void dependencyGraphFS(std::vector<double> &x, const std::vector<double> &a, std::vector<double> &b){
-    const int N = x.size();
-    const int block_size = 512;
-    const int num_blocks = N / block_size;
-
-    std::vector<NodePtr> nodes(num_blocks * num_blocks);
-    //创建图对象
-    tbb::flow::graph g;
-    for(int r = num_blocks-1; r >= 0; --r){
-        for(int c = r; c >= 0; --c){
-            //创建图节点
-            nodes[r * num_blocks + c] = createNode(g, r, c, block_size, x, a, b);
-            //链接
-            addEdges(nodes, r, c, block_size, num_blocks);
+    Wavefront::lowerTriangular(num_blocks, [&](int r, int c) {
+        int i_start = r * block_size, i_end = std::min(i_start + block_size, N);
+        int j_start = c * block_size, j_max = std::min(j_start + block_size, N) - 1;
+        for (int i = i_start; i < i_end; ++i) {
+            int j_end = (i <= j_max) ? i : j_max + 1;
+            for (int j = j_start; j < j_end; ++j) {
+                b[i] -= a[j + i * N] * x[j];
+            }
+            if (j_end == i) {
+                x[i] = b[i] / a[i + i * N];
+            }
         }
-    }
-    //传入消息
-    nodes[0]->try_put(tbb::flow::continue_msg());
-    //等待完成
-    g.wait_for_all();
+    });
 }
 
 
 //初始化
-static std::vector<double> initForwardSubstitution(std::vector<double> &x,
-                                                   std::vector<double> &a,
-                                                   std::vector<double> &b) {
+static void initForwardSubstitution(std::vector<double> &x, std::vector<double> &a, std::vector<double> &b) {
     const int N = x.size();
     for (int i = 0; i < N; ++i) {
         x[i] = 0;
@@ -125,26 +78,232 @@ static std::vector<double> initForwardSubstitution(std::vector<double> &x,
             a[j + i * N] = 1 + j * i;
         }
     }
+}
 
-    std::vector<double> b_tmp = b;
-    std::vector<double> x_gold = x;
+//初始化分块存储的版本，矩阵元素与initForwardSubstitution相同
+static void initBlockedForwardSubstitution(std::vector<double> &x, Triangular::BlockedLowerMatrix &a,
+                                           std::vector<double> &b) {
+    const int N = x.size();
+    a.fill([](int i, int j) { return 1.0 + (double) j * i; });
     for (int i = 0; i < N; ++i) {
-        for (int j = 0; j < i; ++j) {
-            b_tmp[i] -= a[j + i * N] * x_gold[j];
+        x[i] = 0;
+        b[i] = (double) i * i;
+    }
+}
+
+//输出耗时和相对残差||b - Ax|| / (||A|| ||x|| + ||b||)，A是分块存储的同一个矩阵（稠密版本的元素与它相同）
+template <typename Solve>
+void runFS(const char *name, std::vector<double> x, std::vector<double> b,
+           const Triangular::BlockedLowerMatrix &A, double norm_a, Solve solve) {
+    const std::vector<double> b_orig = b;
+    tbb::tick_count t0 = tbb::tick_count::now();
+    solve(x, b);
+    double time = (tbb::tick_count::now() - t0).seconds();
+    std::cout << name << " == " << time << " seconds, residual "
+              << Mixed::relativeResidual(A, norm_a, x, b_orig) << std::endl;
+}
+
+//稀疏下三角测试矩阵：每行对角元 + 若干个随机的更早的列（距离64到4096行）
+static Sparse::CsrMatrix makeSparseLower(int n, int per_row, unsigned seed) {
+    Sparse::CsrMatrix L;
+    L.n = n;
+    L.row_ptr.push_back(0);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> off(-0.1, 0.1);
+    std::vector<int> cols;
+    for (int i = 0; i < n; ++i) {
+        cols.clear();
+        if (i >= 64) {
+            std::uniform_int_distribution<int> dist(std::max(0, i - 4096), i - 64);
+            for (int k = 0; k < per_row; ++k) {
+                cols.push_back(dist(rng));
+            }
+            std::sort(cols.begin(), cols.end());
+            cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+        }
+        for (int j : cols) {
+            L.col_idx.push_back(j);
+            L.values.push_back(off(rng));
+        }
+        L.col_idx.push_back(i);
+        L.values.push_back(1.0 + (i % 7));
+        L.row_ptr.push_back(L.col_idx.size());
+    }
+    L.patternChanged();
+    return L;
+}
+
+//稀疏前代：分析一次，之后多次求解复用分析结果
+static void runSparseFS(int n) {
+    Sparse::CsrMatrix L = makeSparseLower(n, 7, 2023);
+    std::vector<double> b(n), x_gold(n), x(n);
+    for (int i = 0; i < n; ++i) {
+        b[i] = std::sin(0.001 * i);
+    }
+
+    Sparse::SolverCache cache;
+    tbb::tick_count t0 = tbb::tick_count::now();
+    const Sparse::LowerSolver &solver = cache.get(L);
+    double analysis_time = (tbb::tick_count::now() - t0).seconds();
+    if (!solver.valid()) {
+        std::cerr << "sparse matrix is missing diagonal entries" << std::endl;
+        return;
+    }
+
+    t0 = tbb::tick_count::now();
+    solver.serialSolve(L.values, b, x_gold);
+    double serial_time = (tbb::tick_count::now() - t0).seconds();
+
+    const int repeats = 10;
+    t0 = tbb::tick_count::now();
+    for (int rep = 0; rep < repeats; ++rep) {
+        //结构编号不变，缓存命中（O(1)），不重新分析
+        cache.get(L).solve(L.values, b, x);
+    }
+    double level_time = (tbb::tick_count::now() - t0).seconds() / repeats;
+
+    double max_err = 0;
+    for (int i = 0; i < n; ++i) {
+        max_err = std::max(max_err, std::abs(x[i] - x_gold[i]));
+    }
+    std::cout << "sparse n == " << n << ", nnz == " << L.nnz() << ", levels == " << solver.numLevels() << std::endl;
+    std::cout << "  analysis == " << analysis_time << " seconds" << std::endl;
+    std::cout << "  serial sparse FS == " << serial_time << " seconds" << std::endl;
+    std::cout << "  level-scheduled sparse FS == " << level_time << " seconds, max error " << max_err << std::endl;
+}
+
+//混合精度：低精度存储的矩阵做前代，double残差迭代修正到tolerance，输出相对残差
+template <typename Low>
+void runMixedFS(const char *name, const Triangular::BlockedLowerMatrix &A, const std::vector<double> &b,
+                double tolerance) {
+    const int N = A.size();
+    tbb::tick_count t0 = tbb::tick_count::now();
+    auto A_low = Mixed::convert<Low>(A);
+    double convert_time = (tbb::tick_count::now() - t0).seconds();
+
+    //单次低精度求解，不修正
+    std::vector<double> x(N), b_tmp = b;
+    t0 = tbb::tick_count::now();
+    Triangular::parallelBlockedFS(x, A_low, b_tmp);
+    double solve_time = (tbb::tick_count::now() - t0).seconds();
+    const double norm_a = Mixed::normInf(A);
+    double low_residual = Mixed::relativeResidual(A, norm_a, x, b);
+
+    t0 = tbb::tick_count::now();
+    Mixed::RefineResult result = Mixed::refine(x, A, A_low, b, tolerance);
+    double refine_time = (tbb::tick_count::now() - t0).seconds();
+
+    std::cout << name << " (" << (A_low.bytes() >> 20) << " MB, convert " << convert_time << " s) == "
+              << solve_time << " seconds, residual " << low_residual << std::endl;
+    std::cout << "  + refinement == " << refine_time << " seconds, " << result.iterations << " solves, residual "
+              << result.residual << (result.converged ? "" : " (not converged)") << std::endl;
+}
+
+//命令行的整数参数，不是整数或不在[lo, hi]里时打印错误并返回false
+static bool parseInt(const char *name, const std::string &arg, int lo, int hi, int &value) {
+    try {
+        std::size_t pos = 0;
+        value = std::stoi(arg, &pos);
+        if (pos == arg.size() && value >= lo && value <= hi) {
+            return true;
         }
-        x_gold[i] = b_tmp[i] / a[i + i * N];
+    } catch (const std::exception &) {
     }
-    return x_gold;
+    std::cerr << "Error: " << name << " must be an integer in [" << lo << ", " << hi << "], got " << arg << std::endl;
+    return false;
 }
 
-int main() {
-    const int N = 32768;
+int main(int argc, char **argv) {
+    int N = 32768;
+    if (argc > 1 && !parseInt("N", argv[1], 1, std::numeric_limits<int>::max(), N)) {
+        return 1;
+    }
+    //块大小：命令行给定（1 <= block_size <= N），或者"auto"（默认）用本机保存的调优结果，没有就先调优
+    const std::string block_arg = argc > 2 ? argv[2] : "auto";
+    int block_size = 0;
+    if (block_arg == "auto") {
+        block_size = Autotune::bestBlockSize(N);
+    } else if (!parseInt("block_size", block_arg, 1, N, block_size)) {
+        return 1;
+    }
+    //混合精度迭代修正的目标相对残差
+    const double tolerance = argc > 3 ? std::atof(argv[3]) : 1e-12;
+    //稠密存储N*N个double，N = 32768时是8GB，超过这个大小就只跑分块存储的版本
+    const std::size_t dense_limit = std::size_t(2) << 30;
 
-    std::vector<double> a(N * N);
     std::vector<double> b(N);
     std::vector<double> x(N);
 
-    auto x_gold = initForwardSubstitution(x, a, b);
+    //分块存储：只存下三角的块，块内连续
+    Triangular::BlockedLowerMatrix packed(N, block_size);
+    initBlockedForwardSubstitution(x, packed, b);
+    std::cout << "N == " << N << ", block_size == " << block_size << ", packed matrix " << (packed.bytes() >> 20) << " MB" << std::endl;
+
+    const double norm_a = Mixed::normInf(packed);
+    runFS("serialBlockedFS", x, b, packed, norm_a, [&](std::vector<double> &x, std::vector<double> &b) {
+        Triangular::serialBlockedFS(x, packed, b);
+    });
+    runFS("parallelBlockedFS", x, b, packed, norm_a, [&](std::vector<double> &x, std::vector<double> &b) {
+        Triangular::parallelBlockedFS(x, packed, b);
+    });
+
+    runMixedFS<float>("parallelBlockedFS<float>", packed, b, tolerance);
+    runMixedFS<Mixed::BFloat16>("parallelBlockedFS<bf16>", packed, b, tolerance);
+
+    //多右端项：第k列是(1 + k) * b
+    const int nrhs = 128;
+    std::vector<double> B((std::size_t) N * nrhs), X((std::size_t) N * nrhs);
+    for (int i = 0; i < N; ++i) {
+        for (int k = 0; k < nrhs; ++k) {
+            B[(std::size_t) i * nrhs + k] = (1 + k) * b[i];
+        }
+    }
+    auto runTRSM = [&](const char *name, auto solve) {
+        std::vector<double> X_run = X, B_run = B;
+        tbb::tick_count t0 = tbb::tick_count::now();
+        solve(X_run, B_run);
+        double time = (tbb::tick_count::now() - t0).seconds();
+        //每列的残差要读一遍整个矩阵，只检查首、中、尾三列，取最大
+        double residual = 0;
+        std::vector<double> x_k(N), b_k(N);
+        for (int k : {0, nrhs / 2, nrhs - 1}) {
+            for (int i = 0; i < N; ++i) {
+                x_k[i] = X_run[(std::size_t) i * nrhs + k];
+                b_k[i] = B[(std::size_t) i * nrhs + k];
+            }
+            residual = std::max(residual, Mixed::relativeResidual(packed, norm_a, x_k, b_k));
+        }
+        std::cout << name << " (" << nrhs << " rhs) == " << time << " seconds, "
+                  << (double) N * N * nrhs / time * 1e-9 << " GFLOP/s, residual " << residual << std::endl;
+    };
+    runTRSM("serialBlockedTRSM", [&](std::vector<double> &X, std::vector<double> &B) {
+        Triangular::serialBlockedTRSM(X, packed, B, nrhs);
+    });
+    runTRSM("parallelBlockedTRSM", [&](std::vector<double> &X, std::vector<double> &B) {
+        Triangular::parallelBlockedTRSM(X, packed, B, nrhs);
+    });
+    //对比：逐个右端项求解
+    runTRSM("parallelBlockedFS x rhs", [&](std::vector<double> &X, std::vector<double> &B) {
+        std::vector<double> x_k(N), b_k(N);
+        for (int k = 0; k < nrhs; ++k) {
+            for (int i = 0; i < N; ++i) {
+                b_k[i] = B[(std::size_t) i * nrhs + k];
+            }
+            Triangular::parallelBlockedFS(x_k, packed, b_k);
+            for (int i = 0; i < N; ++i) {
+                X[(std::size_t) i * nrhs + k] = x_k[i];
+            }
+        }
+    });
+
+    runSparseFS(N * 32);
+
+    if ((std::size_t) N * N * sizeof(double) > dense_limit) {
+        std::cout << "dense matrix too large, skipping dense variants" << std::endl;
+        return 0;
+    }
+    std::vector<double> a((std::size_t) N * N);
+    initForwardSubstitution(x, a, b);
 
     /*for(int i = 0; i < N; ++i){
         for(int j = 0; j < N; ++j){
@@ -152,52 +311,14 @@ int main() {
         }
         std::cout << std::endl;
     }*/
-    double serial_time = 0.0;
-    {
-        tbb::tick_count t0 = tbb::tick_count::now();
-//        serialFS(x,a,b);
-//        serialBlockFS(x, a, b);
-//        parallelFS(x, a, b);
-        dependencyGraphFS(x, a, b);
-        serial_time = (tbb::tick_count::now() - t0).seconds();
-    }
-    for (int i = 0; i < N; ++i) {
-        if (x[i] > 1.1 * x_gold[i] || x[i] < 0.9 * x_gold[i]) {
-            std::cerr << "  at " << i << " " << x[i] << " != " << x_gold[i] << std::endl;
-        }
-    }
-    std::cout << "serial_time == " << serial_time << " seconds" << std::endl;
+    runFS("serialFS", x, b, packed, norm_a, [&](std::vector<double> &x, std::vector<double> &b) {
+        serialFS(x, a, b);
+    });
+    runFS("serialBlockFS", x, b, packed, norm_a, [&](std::vector<double> &x, std::vector<double> &b) {
+        serialBlockFS(x, a, b, block_size);
+    });
+    runFS("parallelFS", x, b, packed, norm_a, [&](std::vector<double> &x, std::vector<double> &b) {
+        parallelFS(x, a, b, block_size);
+    });
     return 0;
 }
-
-NodePtr createNode(tbb::flow::graph &g, int r, int c, int block_size,
-                   std::vector<double> &x, const std::vector<double> &a, std::vector<double> &b){
-    const int N = x.size();
-    return std::make_shared<Node>(
-            g,
-            [r, c, block_size, N, &x, &a, &b](const tbb::flow::continue_msg & msg){
-                int i_start = r * block_size, i_end = i_start + block_size;
-                int j_start = c * block_size, j_max = j_start + block_size -1;
-                for(int i = i_start; i < i_end; ++i){
-                    int j_end = (i <= j_max) ? i : j_max+1;
-                    for(int j = j_start; j < j_end; ++j){
-                        b[i] -= a[j + i*N] * x[j];
-                    }
-                    if(j_end == i){
-                        x[i] = b[i] / a[i + i*N];
-                    }
-                }
-                return msg;
-            }
-        );
-}
-
-void addEdges(std::vector<NodePtr> &nodes, int r, int c, int block_size, int num_blocks){
-    NodePtr np = nodes[r * num_blocks + c];
-    if(c + 1 < num_blocks && r != c){
-        tbb::flow::make_edge(*np, *nodes[r * num_blocks + c + 1]);
-    }
-    if(r + 1 < num_blocks){
-        tbb::flow::make_edge(*np, *nodes[(r+1) * num_blocks + c]);
-    }
-}
\ No newline at end of file
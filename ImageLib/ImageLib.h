@@ -27,8 +27,8 @@ SPDX-License-Identifier: MIT
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <fstream>
-#include <iostream>
 #include <memory>
 #include <string>
 #include <vector>
@@ -58,15 +58,48 @@ namespace ImageLib {
 
         void write(const char* fname) const {
             if(myData.empty()) {
-                std::cout << "Warning: Image is empty.\n";
+                std::printf("Warning: Image is empty.\n");
                 return;
             }
-            std::ofstream stream{fname};
+            std::ofstream stream{fname, std::ios::binary};
             stream.write((char*)&file.type, file.sizeRest);
             stream.write((char*)&info, info.size);
             stream.write((char*)myData[0].bgra, myData.size()*sizeof(myData[0]));
         }
 
+        //read a BMP file (24 or 32 bits per pixel, uncompressed), rows are kept in file order like write()
+        bool read(const char* fname) {
+            std::ifstream stream{fname, std::ios::binary};
+            std::uint8_t header[54];
+            if(!stream.read((char*)header, sizeof(header)) || header[0] != 'B' || header[1] != 'M') {
+                std::printf("Warning: cannot read BMP file %s\n", fname);
+                return false;
+            }
+            auto u16 = [&header](int o) { return std::uint32_t(header[o] | header[o+1] << 8); };
+            auto u32 = [&u16](int o) { return std::uint32_t(u16(o) | u16(o+2) << 16); };
+            const std::uint32_t offBits = u32(10);
+            const int w = (std::int32_t)u32(18), h = std::abs((std::int32_t)u32(22));
+            const int bitCount = u16(28);
+            if((bitCount != 24 && bitCount != 32) || u32(30) != 0) {
+                std::printf("Warning: unsupported BMP format in %s\n", fname);
+                return false;
+            }
+            reset(w, h);
+            const int bytesPerPixel = bitCount / 8;
+            const int rowSize = (w*bytesPerPixel + 3) / 4 * 4;
+            std::vector<std::uint8_t> row(rowSize);
+            stream.seekg(offBits);
+            for(int i = 0; i < h; ++i) {
+                if(!stream.read((char*)row.data(), rowSize)) {
+                    std::printf("Warning: truncated BMP file %s\n", fname);
+                    return false;
+                }
+                for(int j = 0; j < w; ++j)
+                    myRows[i][j] = Pixel(row[j*bytesPerPixel], row[j*bytesPerPixel+1], row[j*bytesPerPixel+2]);
+            }
+            return true;
+        }
+
         void fill(std::uint8_t r, std::uint8_t g, std::uint8_t b, int x = -1, int y = -1) {
             if(myData.empty())
                 return;
@@ -101,7 +134,7 @@ namespace ImageLib {
     private:
         void reset(int w, int h) {
             if(w <= 0 || h <= 0) {
-                std::cout << "Warning: Invalid Image size.\n";
+                std::printf("Warning: Invalid Image size.\n");
                 return;
             }
 
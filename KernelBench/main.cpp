@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <tbb/tbb.h>
+#include "ImageLib.h"
+#include "PixelKernels.h"
+#include "CombiningHistogram.h"
+#include "HistogramKernels.h"
+#include "CaseKernels.h"
+#include "ReduceKernels.h"
+#include "TriangularMatrix.h"
+
+//各示例热点kernel的单独计时，给PGO流程（pgo.sh）对比优化前后用
+//- fractal：ImageLib的calcOnePixel（makeFractalImage串行填满一张图）
+//- gamma、tint：SIMD的PixelKernels，逐行处理一张图
+//- histogram：Mutex里的串行直方图循环、HistogramKernels，以及AdaptiveHistogram的私有桶、combining两种模式（单线程）
+//- flipCase：Pipeline的大小写互换；sumNaive、sumNeumaier：ReduceStudy的数组求和
+//- fsBlock：ForwardSubstitution的分块前代（串行，块内核是dot + gemvUpdate + trsvLower）
+//gamma、tint、histogramKernel、flipCase、sum*是按CPU选版本的kernel，选中的版本打印到stderr
+//用法：KernelBenchmark [train]
+//  不带参数时每个kernel跑3次取最短，输出"kernel名 秒数"，pgo.sh解析这个输出
+//  train是PGO的训练负载：规模更小、数据不同，覆盖同样的代码路径，分支的比例和测量时相近
+bool train = false;
+
+void report(const std::string &name, const std::function<void()> &kernel) {
+    double best = 1e300;
+    for (int k = 0; k < (train ? 1 : 3); ++k) {
+        tbb::tick_count t0 = tbb::tick_count::now();
+        kernel();
+        best = std::min(best, (tbb::tick_count::now() - t0).seconds());
+    }
+    std::cout << std::left << std::setw(20) << name << std::right << std::setw(12) << std::setprecision(5)
+              << std::fixed << best << std::defaultfloat << std::endl;
+}
+
+//测量时和SIMD示例一样是800x800、放大2000000倍；train时是同一区域的1/4分辨率（放大倍数同比例缩小），
+//每个像素的迭代次数分布（calcOnePixel的分支比例）和测量时相近，像素数是1/16
+std::shared_ptr<ImageLib::Image> fractalImage() {
+    const double magn = 2000000;
+    if (!train) {
+        return ImageLib::makeFractalImage(magn);
+    }
+    const int scale = 4;
+    const int width = ImageLib::IMAGE_WIDTH / scale, height = ImageLib::IMAGE_HEIGHT / scale;
+    auto image = std::make_shared<ImageLib::Image>("fractal_train", width, height);
+    ImageLib::Fractal fr(width, height, magn / scale);
+    image->fill([&fr](int x, int y) { return fr.calcOnePixel(x, y); });
+    return image;
+}
+
+void imageKernels() {
+    std::shared_ptr<ImageLib::Image> image;
+    report("fractal", [&] { image = fractalImage(); });
+
+    ImageLib::Image out("out", image->width(), image->height());
+    auto &in_rows = image->rows();
+    auto &out_rows = out.rows();
+    const double tints[] = {0.75, 0, 0};
+    const int repeat = train ? 2 : 20;
+    report("gamma", [&] {
+        for (int k = 0; k < repeat; ++k)
+            for (int i = 0; i < image->height(); ++i)
+                PixelKernels::gammaKernel()(in_rows[i], out_rows[i], image->width(), 1.4);
+    });
+    report("tint", [&] {
+        for (int k = 0; k < repeat; ++k)
+            for (int i = 0; i < image->height(); ++i)
+                PixelKernels::tintKernel()(in_rows[i], out_rows[i], image->width(), tints);
+    });
+}
+
+void histogramKernels() {
+    const std::size_t n = train ? (1 << 22) : (1 << 26);
+    const int num_bins = 256;
+    std::vector<std::uint8_t> image(n);
+    std::mt19937 rng(train ? 7 : 42);
+    for (auto &v : image) {
+        //一半数据落在少数几个桶里，一半均匀
+        v = (rng() & 1) ? (std::uint8_t) (rng() % 4) : (std::uint8_t) rng();
+    }
+    std::vector<long> hist(num_bins);
+    report("histogramSerial", [&] {
+        std::fill(hist.begin(), hist.end(), 0);
+        std::for_each(image.begin(), image.end(), [&](std::uint8_t i) { hist[i]++; });
+    });
+    std::vector<long> hist_k(num_bins);
+    report("histogramKernel", [&] {
+        std::fill(hist_k.begin(), hist_k.end(), 0);
+        HistogramKernels::countBytesKernel()(image.data(), image.size(), hist_k.data());
+    });
+    if (hist_k != hist) {
+        std::cerr << "histogram kernel mismatch" << std::endl;
+    }
+    for (auto mode : {Combining::Mode::Privatized, Combining::Mode::Combining}) {
+        report(std::string("histogram") + (mode == Combining::Mode::Privatized ? "Private" : "Combining"), [&] {
+            Combining::AdaptiveHistogram h(num_bins, false, mode, 1);
+            h.add(image.begin(), image.end());
+            if (h.counts() != hist) {
+                std::cerr << "histogram mismatch" << std::endl;
+            }
+        });
+    }
+}
+
+void textKernels() {
+    const std::size_t n = train ? (1 << 22) : (1 << 26);
+    std::string text(n, ' ');
+    for (std::size_t i = 0; i < n; ++i) {
+        text[i] = (char) ('A' + i % ('z' - 'A' + 1));
+    }
+    report("flipCase", [&] { CaseKernels::flipCaseKernel()(&text[0], text.size()); });
+
+    std::vector<double> a(n);
+    std::mt19937_64 rng(train ? 7 : 42);
+    std::uniform_real_distribution<double> value(-1.0, 1.0);
+    for (auto &x : a) {
+        x = value(rng);
+    }
+    double naive = 0, neumaier = 0;
+    report("sumNaive", [&] { naive = ReduceKernels::sum<FloatReduce::Method::Naive>(a.data(), a.size()); });
+    report("sumNeumaier", [&] { neumaier = ReduceKernels::sum<FloatReduce::Method::Neumaier>(a.data(), a.size()); });
+    if (naive != FloatReduce::sum<FloatReduce::Method::Naive>(a.data(), a.size()) ||
+        neumaier != FloatReduce::sum<FloatReduce::Method::Neumaier>(a.data(), a.size())) {
+        std::cerr << "sum kernel mismatch" << std::endl;
+    }
+}
+
+void fsKernels() {
+    const int n = train ? 2048 : 8192;
+    const int block_size = 128;
+    Triangular::BlockedLowerMatrix a(n, block_size);
+    a.fill([](int i, int j) { return i == j ? 1.0 + i : 1.0 / (1.0 + i - j); });
+    std::vector<double> b(n), x(n);
+    report("fsBlock", [&] {
+        for (int i = 0; i < n; ++i) {
+            b[i] = 1.0 + (i % 7);
+        }
+        Triangular::serialBlockedFS(x, a, b);
+    });
+}
+
+int main(int argc, char **argv) {
+    train = argc > 1 && std::strcmp(argv[1], "train") == 0;
+    //单线程计时，只看kernel本身
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, 1);
+    Dispatch::report(std::cerr);
+    imageKernels();
+    histogramKernels();
+    textKernels();
+    fsKernels();
+    return 0;
+}
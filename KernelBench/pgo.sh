@@ -0,0 +1,69 @@
+#!/usr/bin/env bash
+# PGO流程：
+#   1. Release构建（对照）
+#   2. 插桩构建（SAMPLES_PGO=GENERATE），在临时目录里跑每个示例的训练负载，profile写到build/pgo-profiles
+#   3. 用profile + LTO重新构建（SAMPLES_PGO=USE）
+#   4. 分别运行Release和PGO版本的KernelBenchmark，输出每个kernel的耗时和加速比
+# 用法：KernelBench/pgo.sh [构建目录，默认build]；JOBS环境变量指定并行编译数
+set -euo pipefail
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BUILD=$(mkdir -p "${1:-$ROOT/build}" && cd "${1:-$ROOT/build}" && pwd)
+JOBS=${JOBS:-$(nproc)}
+PROFILES=$BUILD/pgo-profiles
+
+configure_and_build() {
+    local dir=$1
+    shift
+    cmake -S "$ROOT" -B "$BUILD/$dir" -DCMAKE_BUILD_TYPE=Release -DSAMPLES_PGO_DIR="$PROFILES" "$@" > /dev/null
+    cmake --build "$BUILD/$dir" -j "$JOBS" > /dev/null
+}
+
+echo "== Release build"
+configure_and_build release -DSAMPLES_PGO=OFF
+
+echo "== Instrumented build"
+rm -rf "$PROFILES"
+configure_and_build pgo-generate -DSAMPLES_PGO=GENERATE
+
+# 训练负载：每个示例一个有代表性的运行，参数让它在几十秒内结束；输出文件（bmp等）写在临时目录里
+echo "== Training"
+TRAIN_DIR=$(mktemp -d)
+trap 'rm -rf "$TRAIN_DIR"' EXIT
+BIN=$BUILD/pgo-generate
+TRAINING=(
+    "Algorithms/Algorithms"
+    "Concurrent/Concurrent"
+    "FlowGraph/FlowGraph"
+    "FlowGraph2/FlowGraph2"
+    "ForwardSubstitution/ForwardSubstitution 4096 64"
+    "KernelBench/KernelBenchmark train"
+    "Mutex/Mutex"
+    "ParallelFor/ParallelFor"
+    "Pipeline/Pipeline"
+    "ReduceStudy/ReduceStudy"
+    "SIMD/SIMD"
+    "ScanStudy/ScanStudy"
+    "TimeStudy/TimeStudy"
+)
+for run in "${TRAINING[@]}"; do
+    read -r exe args <<< "$run"
+    start=$(date +%s)
+    (cd "$TRAIN_DIR" && "$BIN/$exe" $args > /dev/null)
+    echo "  $exe${args:+ $args}: $(( $(date +%s) - start )) s"
+done
+
+# Clang的原始profile要合并成一个文件
+if compgen -G "$PROFILES/*.profraw" > /dev/null; then
+    llvm-profdata merge -o "$PROFILES/samples.profdata" "$PROFILES"/*.profraw
+fi
+
+echo "== Optimized build (PGO + LTO)"
+configure_and_build pgo-use -DSAMPLES_PGO=USE
+
+echo "== Kernel timings (best of 3, single thread)"
+"$BUILD/release/KernelBench/KernelBenchmark" > "$BUILD/kernels-release.txt"
+"$BUILD/pgo-use/KernelBench/KernelBenchmark" > "$BUILD/kernels-pgo.txt"
+printf "%-20s %12s %12s %9s\n" kernel release "pgo+lto" speedup
+join <(sort "$BUILD/kernels-release.txt") <(sort "$BUILD/kernels-pgo.txt") |
+    awk '{ printf "%-20s %12.5f %12.5f %8.2fx\n", $1, $2, $3, $2 / $3 }'
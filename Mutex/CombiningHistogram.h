@@ -0,0 +1,212 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <tbb/tbb.h>
+#include "Locks.h"
+#include "Padded.h"
+
+//并发直方图（计数器）：三种更新方式，按观察到的竞争程度自动切换
+//- Atomic：直接对共享的桶做原子加（fetch_add），不需要合并；自适应时每个线程每SAMPLE_PERIOD批抽一批改用CAS，
+//  CAS失败的比例就是竞争的度量
+//- Privatized：每个线程一份私有的桶，读的时候合并；桶多、线程多时占内存
+//- Combining：flat combining，线程把增量攒成一批发布到自己的发布槽里，拿到combiner锁的线程
+//  一次处理所有已发布的批次，用普通的加法写共享的桶；热点桶只被combiner一个线程写，不会在核之间来回传
+//自适应时从Atomic开始，每个线程抽样满一个周期时看自己的CAS失败率，超过阈值后切到Privatized（私有桶总数不大时）或Combining，
+//之后不再切回（数据的倾斜程度在一次统计中通常不会变）
+namespace Combining {
+
+    enum class Mode { Atomic, Privatized, Combining };
+
+    inline const char *modeName(Mode m) {
+        switch (m) {
+            case Mode::Atomic: return "atomic";
+            case Mode::Privatized: return "privatized";
+            case Mode::Combining: return "combining";
+        }
+        return "";
+    }
+
+    //一批增量的元素个数，也是模式检查的粒度
+    const int BATCH = 256;
+    //Atomic模式下每个线程每这么多批抽一批用CAS
+    const long SAMPLE_PERIOD = 16;
+    //每个线程抽样的操作数满一个周期时判断是否切换（约EPOCH * SAMPLE_PERIOD次操作）
+    const long EPOCH = 1 << 12;
+    //CAS失败次数 / 操作数超过这个比例，认为竞争严重
+    const double CONTENTION_RATE = 0.05;
+    //私有桶总数（桶数 x 线程数）不超过这个值时用Privatized，否则用Combining
+    const std::size_t PRIVATE_LIMIT = 1 << 16;
+
+    class AdaptiveHistogram {
+    public:
+        //adaptive为false时固定用initial模式；num_slots是并发线程数（要在别的arena里用时传那个arena的并发数）
+        explicit AdaptiveHistogram(int num_bins, bool adaptive = true, Mode initial = Mode::Atomic,
+                                   int num_slots = tbb::this_task_arena::max_concurrency())
+                : myNumBins(num_bins), myAdaptive(adaptive), myMode(initial),
+                  myShared(num_bins), myPrivate(std::vector<long>(), num_slots),
+                  myRecords(num_slots), myCombined(num_bins, 0), mySampling(Sampling(), num_slots) {
+            for (auto &record : myRecords) {
+                record.bins.resize(BATCH);
+            }
+        }
+
+        Mode mode() const { return myMode.load(std::memory_order_relaxed); }
+
+        //[first, last)里每个元素是一个桶的下标，各加一
+        template <typename It>
+        void add(It first, It last) {
+            while (first != last) {
+                It batch_end = first;
+                for (int k = 0; k < BATCH && batch_end != last; ++k) {
+                    ++batch_end;
+                }
+                switch (mode()) {
+                    case Mode::Atomic:
+                        addAtomic(first, batch_end);
+                        break;
+                    case Mode::Privatized:
+                        addPrivate(first, batch_end);
+                        break;
+                    case Mode::Combining:
+                        addCombining(first, batch_end);
+                        break;
+                }
+                first = batch_end;
+            }
+        }
+
+        //合并所有方式的结果，调用时不能有并发的add
+        std::vector<long> counts() {
+            std::vector<long> result(myCombined);
+            for (int b = 0; b < myNumBins; ++b) {
+                result[b] += myShared[b].load(std::memory_order_relaxed);
+            }
+            for (std::size_t s = 0; s < myPrivate.size(); ++s) {
+                const auto &bins = myPrivate[s];
+                for (std::size_t b = 0; b < bins.size(); ++b) {
+                    result[b] += bins[b];
+                }
+            }
+            //还没攒满一批、没有发布的增量
+            for (const auto &record : myRecords) {
+                for (int i = 0; i < record.size; ++i) {
+                    ++result[record.bins[i]];
+                }
+            }
+            return result;
+        }
+
+    private:
+        //每个线程的发布槽：pending为true时批次交给combiner，combiner处理完置回false
+        struct alignas(Padded::CACHE_LINE_SIZE) Record {
+            std::atomic<bool> pending{false};
+            int size = 0;
+            std::vector<int> bins;
+        };
+
+        //每个线程自己的抽样统计，只有这个线程读写
+        struct Sampling {
+            long batches = 0;
+            long ops = 0;
+            long failures = 0;
+        };
+
+        template <typename It>
+        void addAtomic(It first, It last) {
+            if (myAdaptive) {
+                Sampling &sampling = mySampling.local();
+                if (++sampling.batches % SAMPLE_PERIOD == 0) {
+                    addSampled(first, last, sampling);
+                    return;
+                }
+            }
+            for (; first != last; ++first) {
+                myShared[*first].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        //抽样的一批用CAS，统计失败次数；满一个周期时按本线程的失败率决定是否切换，不读别的线程的计数
+        template <typename It>
+        void addSampled(It first, It last, Sampling &sampling) {
+            for (; first != last; ++first, ++sampling.ops) {
+                std::atomic<long> &bin = myShared[*first];
+                long v = bin.load(std::memory_order_relaxed);
+                while (!bin.compare_exchange_weak(v, v + 1, std::memory_order_relaxed)) {
+                    ++sampling.failures;
+                }
+            }
+            if (sampling.ops < EPOCH) {
+                return;
+            }
+            if (sampling.failures > CONTENTION_RATE * sampling.ops) {
+                const bool small = (std::size_t) myNumBins * myPrivate.size() <= PRIVATE_LIMIT;
+                Mode expected = Mode::Atomic;
+                myMode.compare_exchange_strong(expected, small ? Mode::Privatized : Mode::Combining);
+            }
+            sampling.ops = 0;
+            sampling.failures = 0;
+        }
+
+        template <typename It>
+        void addPrivate(It first, It last) {
+            std::vector<long> &bins = myPrivate.local();
+            if (bins.empty()) {
+                bins.assign(myNumBins, 0);
+            }
+            for (; first != last; ++first) {
+                ++bins[*first];
+            }
+        }
+
+        template <typename It>
+        void addCombining(It first, It last) {
+            Record &record = myRecords.at(Padded::threadSlot());
+            for (; first != last; ++first) {
+                record.bins[record.size++] = *first;
+                if (record.size == BATCH) {
+                    publish(record);
+                }
+            }
+        }
+
+        //发布一批，等它被处理；等待期间抢到combiner锁就自己当combiner
+        void publish(Record &record) {
+            record.pending.store(true, std::memory_order_release);
+            Locks::Backoff backoff;
+            while (record.pending.load(std::memory_order_acquire)) {
+                if (myCombiner.try_lock()) {
+                    combine();
+                    myCombiner.unlock();
+                } else {
+                    backoff.pause();
+                }
+            }
+            record.size = 0;
+        }
+
+        //combiner：处理所有已发布的批次，共享的桶只有持锁的线程写
+        void combine() {
+            for (auto &record : myRecords) {
+                if (record.pending.load(std::memory_order_acquire)) {
+                    for (int i = 0; i < record.size; ++i) {
+                        ++myCombined[record.bins[i]];
+                    }
+                    record.pending.store(false, std::memory_order_release);
+                }
+            }
+        }
+
+        int myNumBins;
+        bool myAdaptive;
+        std::atomic<Mode> myMode;
+        std::vector<std::atomic<long>> myShared;
+        Padded::PerThreadSlots<std::vector<long>> myPrivate;
+        std::vector<Record, tbb::cache_aligned_allocator<Record>> myRecords;
+        tbb::spin_mutex myCombiner;
+        std::vector<long> myCombined;
+        Padded::PerThreadSlots<Sampling> mySampling;
+    };
+
+}
@@ -0,0 +1,28 @@
+#include "HistogramKernels.h"
+#include "DispatchVariant.h"
+
+//这个文件按不同的ISA编译多次，见DispatchVariant.h
+namespace HistogramKernels {
+    namespace SAMPLES_ISA_NS {
+
+        //4份子直方图轮流计数：连续的相同字节落在不同的计数器上，不会排队等上一次加法写回
+        void countBytes(const std::uint8_t *data, std::size_t n, long *bins) {
+            std::uint32_t sub[4][NUM_BINS] = {};
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                ++sub[0][data[i]];
+                ++sub[1][data[i + 1]];
+                ++sub[2][data[i + 2]];
+                ++sub[3][data[i + 3]];
+            }
+            for (; i < n; ++i) {
+                ++sub[0][data[i]];
+            }
+            for (int b = 0; b < NUM_BINS; ++b) {
+                bins[b] += (long) sub[0][b] + sub[1][b] + sub[2][b] + sub[3][b];
+            }
+        }
+    }
+
+    SAMPLES_KERNEL(CountBytes, countBytesKernel, "histogram", countBytes);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Dispatch.h"
+
+//字节直方图的串行kernel：统计一段uint8_t，加到256个桶上
+//HistogramKernels.cpp按ISA编译多次，调用时Dispatch按CPU选版本
+namespace HistogramKernels {
+
+    const int NUM_BINS = 256;
+
+    //每次调用的n小于2^32（内部用32位计数）
+    using CountBytes = void (*)(const std::uint8_t *data, std::size_t n, long *bins);
+
+    //定义在HistogramKernels.cpp的默认编译里（SAMPLES_KERNEL）
+    Dispatch::Kernel<CountBytes> &countBytesKernel();
+
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <tbb/tbb.h>
+#include "Padded.h"
+
+//锁的适配层：各种锁用同一个接口加读锁/写锁，benchmark可以对锁类型做模板
+//- Locks::read(m, f)：持有读锁执行f（互斥锁没有读锁，就是普通加锁）
+//- Locks::write(m, f)：持有写锁执行f
+//- Locks::Traits<M>::NAME：打印用的名字；新的锁类型加一个Traits特化即可
+//另外实现了两个公平的自旋锁：TicketLock（排号）、McsLock（队列，每个等待者只自旋自己的节点）
+namespace Locks {
+
+    //自旋若干次后让出CPU：线程数多于核数时，持锁的线程被换出后还能尽快回来
+    class Backoff {
+    public:
+        void pause() {
+            if (myCount < SPINS_BEFORE_YIELD) {
+                ++myCount;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+        static const int SPINS_BEFORE_YIELD = 64;
+        int myCount = 0;
+    };
+
+    //排号锁：先取号，等叫到自己的号；按到达顺序获得锁
+    //取号和叫号放在不同的cache line，取号的线程不会干扰正在自旋读叫号的线程
+    class TicketLock {
+    public:
+        void lock() {
+            const unsigned ticket = myNext->fetch_add(1, std::memory_order_relaxed);
+            Backoff backoff;
+            while (myServing->load(std::memory_order_acquire) != ticket) {
+                backoff.pause();
+            }
+        }
+        void unlock() {
+            myServing->store(myServing->load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+    private:
+        Padded::padded<std::atomic<unsigned>> myNext;
+        Padded::padded<std::atomic<unsigned>> myServing;
+    };
+
+    //MCS锁：等待者排成链表，每个等待者只在自己的节点上自旋，释放时只通知下一个
+    //节点放在scoped_lock里（栈上），和tbb::queuing_mutex的用法一样
+    class McsLock {
+        struct Node {
+            std::atomic<Node *> next{nullptr};
+            std::atomic<bool> locked{true};
+        };
+
+    public:
+        class scoped_lock {
+        public:
+            explicit scoped_lock(McsLock &m) : myLock(m) {
+                Node *prev = m.myTail.exchange(&myNode, std::memory_order_acq_rel);
+                if (prev != nullptr) {
+                    prev->next.store(&myNode, std::memory_order_release);
+                    Backoff backoff;
+                    while (myNode.locked.load(std::memory_order_acquire)) {
+                        backoff.pause();
+                    }
+                }
+            }
+            ~scoped_lock() {
+                Node *next = myNode.next.load(std::memory_order_acquire);
+                if (next == nullptr) {
+                    //没有后继：把tail从自己改回空
+                    Node *expected = &myNode;
+                    if (myLock.myTail.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+                        return;
+                    }
+                    //有线程刚把自己挂到tail上，等它填好next
+                    Backoff backoff;
+                    while ((next = myNode.next.load(std::memory_order_acquire)) == nullptr) {
+                        backoff.pause();
+                    }
+                }
+                next->locked.store(false, std::memory_order_release);
+            }
+            scoped_lock(const scoped_lock &) = delete;
+            scoped_lock &operator=(const scoped_lock &) = delete;
+
+        private:
+            McsLock &myLock;
+            Node myNode;
+        };
+
+    private:
+        std::atomic<Node *> myTail{nullptr};
+    };
+
+    template <typename M>
+    struct Traits;
+
+    //有lock()/unlock()的互斥锁
+    template <typename M>
+    struct MutexTraits {
+        template <typename F>
+        static void read(M &m, F &&f) { write(m, f); }
+        template <typename F>
+        static void write(M &m, F &&f) {
+            std::lock_guard<M> lock(m);
+            f();
+        }
+    };
+
+    //TBB的互斥锁：scoped_lock
+    template <typename M>
+    struct TbbTraits {
+        template <typename F>
+        static void read(M &m, F &&f) { write(m, f); }
+        template <typename F>
+        static void write(M &m, F &&f) {
+            typename M::scoped_lock lock(m);
+            f();
+        }
+    };
+
+    //TBB的读写锁：scoped_lock(m, is_writer)
+    template <typename M>
+    struct TbbRwTraits {
+        template <typename F>
+        static void read(M &m, F &&f) {
+            typename M::scoped_lock lock(m, false);
+            f();
+        }
+        template <typename F>
+        static void write(M &m, F &&f) {
+            typename M::scoped_lock lock(m, true);
+            f();
+        }
+    };
+
+    template <>
+    struct Traits<tbb::spin_mutex> : TbbTraits<tbb::spin_mutex> {
+        static constexpr const char *NAME = "tbb::spin_mutex";
+    };
+
+    template <>
+    struct Traits<tbb::queuing_mutex> : TbbTraits<tbb::queuing_mutex> {
+        static constexpr const char *NAME = "tbb::queuing_mutex";
+    };
+
+    template <>
+    struct Traits<tbb::spin_rw_mutex> : TbbRwTraits<tbb::spin_rw_mutex> {
+        static constexpr const char *NAME = "tbb::spin_rw_mutex";
+    };
+
+    template <>
+    struct Traits<tbb::queuing_rw_mutex> : TbbRwTraits<tbb::queuing_rw_mutex> {
+        static constexpr const char *NAME = "tbb::queuing_rw_mutex";
+    };
+
+    template <>
+    struct Traits<McsLock> : TbbTraits<McsLock> {
+        static constexpr const char *NAME = "MCS lock";
+    };
+
+    template <>
+    struct Traits<std::mutex> : MutexTraits<std::mutex> {
+        static constexpr const char *NAME = "std::mutex";
+    };
+
+    template <>
+    struct Traits<std::shared_mutex> {
+        static constexpr const char *NAME = "std::shared_mutex";
+        template <typename F>
+        static void read(std::shared_mutex &m, F &&f) {
+            std::shared_lock<std::shared_mutex> lock(m);
+            f();
+        }
+        template <typename F>
+        static void write(std::shared_mutex &m, F &&f) {
+            std::unique_lock<std::shared_mutex> lock(m);
+            f();
+        }
+    };
+
+    template <>
+    struct Traits<TicketLock> : MutexTraits<TicketLock> {
+        static constexpr const char *NAME = "ticket lock";
+    };
+
+    template <typename M, typename F>
+    void read(M &m, F &&f) { Traits<M>::read(m, f); }
+
+    template <typename M, typename F>
+    void write(M &m, F &&f) { Traits<M>::write(m, f); }
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <tbb/tbb.h>
+
+//避免伪共享（false sharing）的工具
+//- padded<T>：对齐并填充到一整个cache line，数组里相邻的元素不会落在同一行
+//- PerThreadSlots<T>：每个线程一个padded槽位，按TBB的线程下标访问，最后合并
+//- ShardedCounter：分片的原子计数器，各线程加到不同的分片上，读时求和
+namespace Padded {
+
+    //C++17的std::hardware_destructive_interference_size，标准库没有提供时用64
+    //GCC会提醒这个值随-mtune变化（影响ABI），这里只在本程序内部使用，关掉这个警告
+#ifdef __cpp_lib_hardware_interference_size
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+    constexpr std::size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+    constexpr std::size_t CACHE_LINE_SIZE = 64;
+#endif
+
+    //独占cache line的T；放进std::vector时配合tbb::cache_aligned_allocator，保证起始地址也对齐
+    template <typename T>
+    struct alignas(CACHE_LINE_SIZE) padded {
+        T value;
+
+        padded() : value() {}
+        explicit padded(const T &v) : value(v) {}
+
+        T &operator*() { return value; }
+        const T &operator*() const { return value; }
+        T *operator->() { return &value; }
+        const T *operator->() const { return &value; }
+    };
+
+    static_assert(sizeof(padded<char>) == CACHE_LINE_SIZE, "padded<T> must fill a cache line");
+
+    template <typename T>
+    using padded_vector = std::vector<padded<T>, tbb::cache_aligned_allocator<padded<T>>>;
+
+    //当前线程在TBB线程池里的下标，不在任务里时（外部线程）返回0
+    inline int threadSlot() {
+        const int index = tbb::this_task_arena::current_thread_index();
+        return index == tbb::task_arena::not_initialized ? 0 : index;
+    }
+
+    //每个线程一个槽位，同一线程在不同任务里拿到同一个槽位
+    //槽位个数默认是当前arena的最大并发数，在别的arena里使用时要传入那个arena的并发数，
+    //否则线程下标超出范围（槽位不是原子的，不能像ShardedCounter那样取模共用）
+    template <typename T>
+    class PerThreadSlots {
+    public:
+        explicit PerThreadSlots(const T &init = T(), int num_slots = tbb::this_task_arena::max_concurrency())
+                : mySlots(num_slots, padded<T>(init)) {}
+
+        T &local() { return mySlots.at(threadSlot()).value; }
+        std::size_t size() const { return mySlots.size(); }
+        T &operator[](std::size_t i) { return mySlots[i].value; }
+        const T &operator[](std::size_t i) const { return mySlots[i].value; }
+
+        //按槽位顺序合并
+        template <typename BinaryOp>
+        T combine(T init, BinaryOp op) const {
+            for (const auto &slot : mySlots) {
+                init = op(init, slot.value);
+            }
+            return init;
+        }
+
+    private:
+        padded_vector<T> mySlots;
+    };
+
+    //分片的原子计数器：add()只碰当前线程的分片（relaxed），value()把所有分片加起来
+    //value()和并发的add()之间没有同步，读到的是某个中间值，适合统计类计数
+    class ShardedCounter {
+    public:
+        explicit ShardedCounter(std::size_t num_shards = tbb::this_task_arena::max_concurrency())
+                : myShards(num_shards) {}
+
+        void add(long delta = 1) {
+            myShards[threadSlot() % myShards.size()].value.fetch_add(delta, std::memory_order_relaxed);
+        }
+        long value() const {
+            long sum = 0;
+            for (const auto &shard : myShards) {
+                sum += shard.value.load(std::memory_order_relaxed);
+            }
+            return sum;
+        }
+        void reset() {
+            for (auto &shard : myShards) {
+                shard.value.store(0, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        padded_vector<std::atomic<long>> myShards;
+    };
+
+}
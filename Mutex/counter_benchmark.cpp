@@ -0,0 +1,98 @@
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <tbb/tbb.h>
+#include "Padded.h"
+
+//计数器的伪共享测试：每个线程做OPS_PER_THREAD次加一，比较不同的计数器布局
+//- shared：所有线程加同一个原子变量
+//- adjacent：每个线程一个原子变量，但挨在一起（同一cache line），伪共享
+//- padded：每个线程一个padded<std::atomic<long>>
+//- sharded：Padded::ShardedCounter，按TBB线程下标选分片
+//- local：PerThreadSlots里本线程的槽位，普通的（非原子）加一；通过volatile访问，每次都真的读写内存，
+//  否则编译器会把整个循环折叠成一次加法
+const long OPS_PER_THREAD = 1 << 24;
+
+//在threads个线程的arena里，把[0, threads)每个下标作为一个任务，body(i)做第i份工作
+double run(int threads, const std::function<void(int)> &body) {
+    tbb::task_arena arena(threads);
+    tbb::tick_count t0 = tbb::tick_count::now();
+    arena.execute([&] {
+        tbb::parallel_for(tbb::blocked_range<int>(0, threads, 1),
+                          [&](const tbb::blocked_range<int> &r) {
+                              for (int i = r.begin(); i != r.end(); ++i) {
+                                  body(i);
+                              }
+                          },
+                          tbb::simple_partitioner());
+    });
+    return (tbb::tick_count::now() - t0).seconds();
+}
+
+void report(const std::string &name, int threads, double seconds, long count) {
+    const long expected = OPS_PER_THREAD * threads;
+    std::cout << std::setw(10) << name << std::setw(10) << threads << std::setw(12) << std::setprecision(4)
+              << expected / seconds / 1e6 << " Mops/s" << (count == expected ? "" : "  WRONG COUNT") << std::endl;
+}
+
+int main() {
+    //允许的线程数不受核数限制，核数少时线程数大于核数的arena也能拿到工作线程
+    tbb::global_control allow(tbb::global_control::max_allowed_parallelism, 8);
+    std::cout << "cache line: " << Padded::CACHE_LINE_SIZE << " bytes, padded<std::atomic<long>>: "
+              << sizeof(Padded::padded<std::atomic<long>>) << " bytes" << std::endl;
+    std::cout << std::setw(10) << "counter" << std::setw(10) << "threads" << std::setw(12) << "throughput" << std::endl;
+    for (int threads : {1, 2, 4, 8}) {
+        std::atomic<long> shared{0};
+        double t = run(threads, [&](int) {
+            for (long k = 0; k < OPS_PER_THREAD; ++k) {
+                shared.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        report("shared", threads, t, shared.load());
+
+        std::vector<std::atomic<long>> adjacent(threads);
+        t = run(threads, [&](int i) {
+            for (long k = 0; k < OPS_PER_THREAD; ++k) {
+                adjacent[i].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        long sum = 0;
+        for (auto &c : adjacent) {
+            sum += c.load();
+        }
+        report("adjacent", threads, t, sum);
+
+        Padded::padded_vector<std::atomic<long>> padded(threads);
+        t = run(threads, [&](int i) {
+            for (long k = 0; k < OPS_PER_THREAD; ++k) {
+                padded[i]->fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        sum = 0;
+        for (auto &c : padded) {
+            sum += c->load();
+        }
+        report("padded", threads, t, sum);
+
+        Padded::ShardedCounter sharded(threads);
+        t = run(threads, [&](int) {
+            for (long k = 0; k < OPS_PER_THREAD; ++k) {
+                sharded.add();
+            }
+        });
+        report("sharded", threads, t, sharded.value());
+
+        Padded::PerThreadSlots<long> slots(0, threads);
+        t = run(threads, [&](int) {
+            volatile long *local = &slots.local();
+            for (long k = 0; k < OPS_PER_THREAD; ++k) {
+                *local = *local + 1;
+            }
+        });
+        report("local", threads, t, slots.combine(0L, std::plus<long>()));
+    }
+    return 0;
+}
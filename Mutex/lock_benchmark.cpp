@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <tbb/tbb.h>
+#include "Locks.h"
+#include "Padded.h"
+
+//锁的比较：NUM_KEYS个槽位，每个槽位一把锁保护一段数据，各线程随机选槽位读或写
+//- 访问模式：hot（90%的操作落在同一个槽位）、uniform（均匀）、read-mostly（均匀，95%是读）
+//- 临界区长度：读/写槽位里的多少个long
+//- 吞吐量是所有线程的操作数 / 总时间；延迟是单次操作（含等锁）的耗时，报告p50、p99、p99.9和最大值
+//用法：LockBenchmark [线程数] [每个线程的操作数]
+const int NUM_KEYS = 256;
+const int MAX_CS_LENGTH = 256;
+
+enum class Profile { Hot, Uniform, ReadMostly };
+
+const char *profileName(Profile p) {
+    switch (p) {
+        case Profile::Hot: return "hot";
+        case Profile::Uniform: return "uniform";
+        case Profile::ReadMostly: return "read-mostly";
+    }
+    return "";
+}
+
+//一个操作：槽位和读/写
+struct Op {
+    int key;
+    bool write;
+};
+
+//每个线程的操作序列事先生成，随机数不计入时间
+std::vector<std::vector<Op>> makeOps(Profile profile, int threads, long ops) {
+    std::vector<std::vector<Op>> result(threads);
+    for (int t = 0; t < threads; ++t) {
+        std::mt19937 rng(t + 1);
+        std::uniform_int_distribution<int> key(0, NUM_KEYS - 1);
+        std::uniform_int_distribution<int> percent(0, 99);
+        result[t].resize(ops);
+        for (auto &op : result[t]) {
+            switch (profile) {
+                case Profile::Hot:
+                    op = Op{percent(rng) < 90 ? 0 : key(rng), true};
+                    break;
+                case Profile::Uniform:
+                    op = Op{key(rng), true};
+                    break;
+                case Profile::ReadMostly:
+                    op = Op{key(rng), percent(rng) < 5};
+                    break;
+            }
+        }
+    }
+    return result;
+}
+
+//锁和它保护的数据，各槽位独占cache line
+template <typename M>
+struct alignas(Padded::CACHE_LINE_SIZE) Slot {
+    M mutex;
+    long data[MAX_CS_LENGTH] = {0};
+};
+
+template <typename M>
+void benchmark(Profile profile, int cs_length, int threads, const std::vector<std::vector<Op>> &ops) {
+    std::vector<Slot<M>, tbb::cache_aligned_allocator<Slot<M>>> slots(NUM_KEYS);
+    std::vector<std::vector<float>> latency(threads);
+    std::atomic<long> checksum{0};
+    tbb::task_arena arena(threads);
+    tbb::tick_count t0 = tbb::tick_count::now();
+    arena.execute([&] {
+        tbb::parallel_for(tbb::blocked_range<int>(0, threads, 1), [&](const tbb::blocked_range<int> &r) {
+            for (int t = r.begin(); t != r.end(); ++t) {
+                auto &lat = latency[t];
+                lat.resize(ops[t].size());
+                long sum = 0;
+                for (std::size_t i = 0; i < ops[t].size(); ++i) {
+                    Slot<M> &slot = slots[ops[t][i].key];
+                    auto start = std::chrono::steady_clock::now();
+                    if (ops[t][i].write) {
+                        Locks::write(slot.mutex, [&] {
+                            for (int k = 0; k < cs_length; ++k) {
+                                ++slot.data[k];
+                            }
+                        });
+                    } else {
+                        Locks::read(slot.mutex, [&] {
+                            for (int k = 0; k < cs_length; ++k) {
+                                sum += slot.data[k];
+                            }
+                        });
+                    }
+                    lat[i] = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+                }
+                checksum += sum;
+            }
+        }, tbb::simple_partitioner());
+    });
+    const double seconds = (tbb::tick_count::now() - t0).seconds();
+
+    //每个写操作给data[0]加一，检查没有丢失的更新
+    long writes = 0, counted = 0;
+    for (int t = 0; t < threads; ++t) {
+        writes += std::count_if(ops[t].begin(), ops[t].end(), [](const Op &op) { return op.write; });
+    }
+    for (const auto &slot : slots) {
+        counted += slot.data[0];
+    }
+    std::vector<float> all;
+    for (const auto &lat : latency) {
+        all.insert(all.end(), lat.begin(), lat.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) { return all[std::min(all.size() - 1, (std::size_t) (p * all.size()))]; };
+    std::cout << std::setw(22) << Locks::Traits<M>::NAME << std::setw(12) << profileName(profile)
+              << std::setw(5) << cs_length << std::fixed << std::setprecision(2)
+              << std::setw(10) << all.size() / seconds / 1e6
+              << std::setw(9) << percentile(0.5) << std::setw(9) << percentile(0.99)
+              << std::setw(10) << percentile(0.999) << std::setw(11) << all.back() << std::defaultfloat
+              << (cs_length == 0 || counted == writes ? "" : "  LOST UPDATES") << std::endl;
+}
+
+template <typename... M>
+void benchmarkAll(Profile profile, int cs_length, int threads, long ops_per_thread) {
+    const auto ops = makeOps(profile, threads, ops_per_thread);
+    (benchmark<M>(profile, cs_length, threads, ops), ...);
+}
+
+int main(int argc, char **argv) {
+    const int threads = argc > 1 ? std::atoi(argv[1]) : 4;
+    const long ops = argc > 2 ? std::atol(argv[2]) : 100000;
+    //线程数可以多于核数
+    tbb::global_control allow(tbb::global_control::max_allowed_parallelism, std::max(threads, 2));
+    std::cout << threads << " threads, " << ops << " ops per thread, latency in us" << std::endl;
+    std::cout << std::setw(22) << "lock" << std::setw(12) << "profile" << std::setw(5) << "cs"
+              << std::setw(10) << "Mops/s" << std::setw(9) << "p50" << std::setw(9) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(11) << "max" << std::endl;
+    for (Profile profile : {Profile::Hot, Profile::Uniform, Profile::ReadMostly}) {
+        for (int cs_length : {1, MAX_CS_LENGTH}) {
+            benchmarkAll<tbb::spin_mutex, tbb::queuing_mutex, tbb::spin_rw_mutex, tbb::queuing_rw_mutex,
+                         std::mutex, std::shared_mutex, Locks::TicketLock, Locks::McsLock>(profile, cs_length,
+                                                                                           threads, ops);
+        }
+    }
+    return 0;
+}
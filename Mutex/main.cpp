@@ -1,14 +1,35 @@
 #include <iostream>
+#include <iomanip>
 #include <tbb/tbb.h>
+#include "Padded.h"
+#include "CombiningHistogram.h"
+#include "HistogramKernels.h"
 
 struct bin{
     std::atomic<int> count; //4 bytes
     uint8_t padding[64 - sizeof(count)];    //60 bytes
 };
-struct bin2{
-    //C++17后，可以用std::hardware_destructive_interference_size替代64
-    alignas(64) std::atomic<int> count;
-};
+//alignas(64)的版本，Padded.h里的padded<T>用std::hardware_destructive_interference_size（有的话）对齐
+using bin2 = Padded::padded<std::atomic<int>>;
+
+//用AdaptiveHistogram统计，adaptive为false时固定用mode；结果与gold比较
+double combiningHistogram(const std::vector<uint8_t>& image, int num_bins, bool adaptive,
+                          Combining::Mode mode, const std::vector<int>& gold){
+    Combining::AdaptiveHistogram hist(num_bins, adaptive, mode);
+    tbb::tick_count t0 = tbb::tick_count::now();
+    parallel_for(tbb::blocked_range<size_t>{0, image.size()},
+                 [&](const tbb::blocked_range<size_t>& r)
+                 {
+                     hist.add(image.begin() + r.begin(), image.begin() + r.end());
+                 });
+    std::vector<long> counts = hist.counts();
+    double t = (tbb::tick_count::now() - t0).seconds();
+    if (!std::equal(gold.begin(), gold.end(), counts.begin()))
+        std::cerr << "AdaptiveHistogram (" << Combining::modeName(mode) << ") failed!!" << std::endl;
+    if (adaptive)
+        std::cout << "  adaptive ended in " << Combining::modeName(hist.mode()) << " mode" << std::endl;
+    return t;
+}
 
 int main(int argc, char** argv) {
 
@@ -154,6 +175,24 @@ int main(int argc, char** argv) {
     t1 = tbb::tick_count::now();
     double r_parallel = (t1 - t0).seconds();
 
+    //parallel_reduce + 按CPU选版本的直方图kernel（HistogramKernels.cpp）
+    t0 = tbb::tick_count::now();
+    std::vector<long> hist_k = parallel_reduce (
+        tbb::blocked_range<size_t>{0, image.size()},
+        std::vector<long>(num_bins),
+        [&image](const tbb::blocked_range<size_t>& r, std::vector<long> v) {
+                HistogramKernels::countBytesKernel()(image.data() + r.begin(), r.size(), v.data());
+                return v;
+            },
+        [](std::vector<long> a, const std::vector<long>& b) {
+            std::transform(a.begin(), a.end(), b.begin(), a.begin(), std::plus<long>());
+            return a;
+        });
+    t1 = tbb::tick_count::now();
+    double k_parallel = (t1 - t0).seconds();
+    if (!std::equal(hist.begin(), hist.end(), hist_k.begin()))
+        std::cerr << "Histogram kernel failed!!" << std::endl;
+
     //cache padding
     std::vector<bin, tbb::cache_aligned_allocator<bin>> hist_p6(num_bins);
     t0 = tbb::tick_count::now();
@@ -177,7 +216,7 @@ int main(int argc, char** argv) {
                  {
                      for(size_t i = r.begin(); i < r.end(); ++i)
                      {
-                         hist_p7[image[i]].count++;
+                         hist_p7[image[i]].value++;
                      }
                  }
     );
@@ -190,11 +229,31 @@ int main(int argc, char** argv) {
     std::cout << "ETC:          " << e_parallel << std::endl;
     std::cout << "combinable:   " << c_parallel << std::endl;
     std::cout << "reduce:       " << r_parallel << std::endl;
+    std::cout << "kernel (" << Dispatch::isaName(HistogramKernels::countBytesKernel().selected()) << "): "
+              << k_parallel << std::endl;
     std::cout << "----cache-----" << std::endl;
     std::cout << "padding1:     " << pad_parallel << std::endl;
     std::cout << "padding2:     " << pad2_parallel << std::endl;
     // std::cout << "Speed-up: " << t_serial/t_parallel << std::endl;
 
+    //flat combining和自适应切换：均匀数据和倾斜数据（90%落在同一个桶）
+    std::vector<uint8_t> skewed(image);
+    for (size_t i = 0; i < skewed.size(); ++i)
+        if (i % 10 != 0) skewed[i] = 0;
+    std::vector<int> hist_skewed(num_bins);
+    std::for_each(skewed.begin(), skewed.end(), [&](uint8_t i){hist_skewed[i]++;});
+    for (auto* data : {&image, &skewed}) {
+        const std::vector<int>& gold = data == &image ? hist : hist_skewed;
+        std::cout << "----" << (data == &image ? "uniform" : "skewed") << "-----" << std::endl;
+        for (auto mode : {Combining::Mode::Atomic, Combining::Mode::Privatized, Combining::Mode::Combining}) {
+            double t = combiningHistogram(*data, num_bins, false, mode, gold);
+            std::cout << std::left << std::setw(14) << std::string(Combining::modeName(mode)) + ":"
+                      << std::right << t << std::endl;
+        }
+        double t = combiningHistogram(*data, num_bins, true, Combining::Mode::Atomic, gold);
+        std::cout << "adaptive:     " << t << std::endl;
+    }
+
     if (hist != hist_p)
         std::cerr << "Parallel computation failed!!" << std::endl;
     return 0;
@@ -0,0 +1,21 @@
+#include "CaseKernels.h"
+#include "DispatchVariant.h"
+
+//这个文件按不同的ISA编译多次，见DispatchVariant.h
+namespace CaseKernels {
+    namespace SAMPLES_ISA_NS {
+
+        //字母的大小写只差0x20这一位：或上0x20后落在'a'..'z'的就是字母，翻转这一位
+        //没有分支，编译器可以按向量宽度一次处理16/32/64个字节
+        void flipCase(char *s, std::size_t n) {
+            unsigned char *p = reinterpret_cast<unsigned char *>(s);
+            for (std::size_t i = 0; i < n; ++i) {
+                const unsigned char c = p[i];
+                const bool alpha = (unsigned char) ((c | 0x20) - 'a') < 26;
+                p[i] = c ^ (alpha ? 0x20 : 0);
+            }
+        }
+    }
+
+    SAMPLES_KERNEL(FlipCase, flipCaseKernel, "flipCase", flipCase);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include "Dispatch.h"
+
+//大小写互换的kernel：ASCII字母大写变小写、小写变大写，其他字节不变（和"C" locale下的toupper/tolower一致）
+//CaseKernels.cpp按ISA编译多次，调用时Dispatch按CPU选版本
+namespace CaseKernels {
+
+    using FlipCase = void (*)(char *s, std::size_t n);
+
+    //定义在CaseKernels.cpp的默认编译里（SAMPLES_KERNEL）
+    Dispatch::Kernel<FlipCase> &flipCaseKernel();
+
+}
@@ -1,24 +1,16 @@
 #include <iostream>
 #include <fstream>
 #include <tbb/tbb.h>
+#include "CaseKernels.h"
 
 using CaseStringPtr = std::shared_ptr<std::string>;
 CaseStringPtr getCaseString(std::ofstream& f);
 void writeCaseString(std::ofstream& f, CaseStringPtr s);
 
-//串行 将字符串中大写变小写
+//串行 将字符串中大写变小写（大小写互换用按CPU选版本的kernel，见CaseKernels.h）
 void fig_2_24(std::ofstream& caseBeforeFile, std::ofstream& caseAfterFile) {
     while (CaseStringPtr s_ptr = getCaseString(caseBeforeFile)) {
-        std::transform(s_ptr->begin(), s_ptr->end(), s_ptr->begin(),
-                       [](char c) -> char {
-                           if (std::islower(c))
-                               return std::toupper(c);
-                           else if (std::isupper(c))
-                               return std::tolower(c);
-                           else
-                               return c;
-                       }
-        );
+        CaseKernels::flipCaseKernel()(&(*s_ptr)[0], s_ptr->size());
         writeCaseString(caseAfterFile, s_ptr);
     }
 }
@@ -45,15 +37,7 @@ void fig_2_27(int num_tokens, std::ofstream &caseBeforeFile, std::ofstream &case
                     tbb::filter_mode::parallel,
                     /* filter body */
                     [](CaseStringPtr s_ptr) -> CaseStringPtr {
-                        std::transform(s_ptr->begin(), s_ptr->end(), s_ptr->begin(),
-                                       [](char c) -> char {
-                                           if (std::islower(c))
-                                               return std::toupper(c);
-                                           else if (std::isupper(c))
-                                               return std::tolower(c);
-                                           else
-                                               return c;
-                                       });
+                        CaseKernels::flipCaseKernel()(&(*s_ptr)[0], s_ptr->size());
                         return s_ptr;
                     }) & // concatenation operation
             /* make the write filter */
@@ -128,6 +112,7 @@ int main() {
         serial_time = (tbb::tick_count::now() - t0).seconds();
     }
     std::cout << "serial_time == " << serial_time << " seconds" << std::endl;
+    Dispatch::report(std::cout);
     return 0;
 
     return 0;
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <tbb/tbb.h>
+
+//浮点求和的并行归约
+//- Naive：普通累加；Kahan、Neumaier：补偿求和，误差与元素个数基本无关；Pairwise：块内两两递归求和，误差O(log n)
+//- 每块内部用LANES个独立的累加器（按下标轮流分配），打断加法的依赖链，便于向量化；分配方式只和下标有关，结果确定
+//- deterministic为true时，数据按固定大小BLOCK_SIZE分块，块的合并顺序由parallel_deterministic_reduce固定，
+//  结果与线程数、调度无关，逐位相同；为false时用parallel_reduce，合并顺序随任务窃取变化
+namespace FloatReduce {
+
+    enum class Method { Naive, Kahan, Neumaier, Pairwise };
+
+    const int LANES = 8;
+    //分块大小只和数据有关，与线程数无关
+    const std::int64_t BLOCK_SIZE = 1 << 14;
+    //两两求和递归到这个长度为止
+    const std::int64_t PAIRWISE_BASE = 128;
+
+    //和 + 补偿项，合并时按Neumaier的方式把另一半的和加进来
+    struct Accumulator {
+        double sum = 0;
+        double comp = 0;
+
+        void add(double x) {
+            const double t = sum + x;
+            if (std::abs(sum) >= std::abs(x)) {
+                comp += (sum - t) + x;
+            } else {
+                comp += (x - t) + sum;
+            }
+            sum = t;
+        }
+        void merge(const Accumulator &other) {
+            add(other.sum);
+            comp += other.comp;
+        }
+        double result() const { return sum + comp; }
+    };
+
+    //合并两个部分和：补偿求和保留补偿项，朴素求和和两两求和直接相加
+    template <Method M>
+    void combine(Accumulator &a, const Accumulator &b) {
+        if constexpr (M == Method::Kahan || M == Method::Neumaier) {
+            a.merge(b);
+        } else {
+            a.sum += b.sum;
+        }
+    }
+
+    //把LANES个累加器按顺序合并成一个
+    template <Method M>
+    Accumulator mergeLanes(const double *s, const double *c) {
+        Accumulator acc;
+        for (int l = 0; l < LANES; ++l) {
+            //Kahan的c是"要减掉的误差"，符号与Neumaier的补偿项相反
+            combine<M>(acc, Accumulator{s[l], M == Method::Kahan ? -c[l] : c[l]});
+        }
+        return acc;
+    }
+
+    //f(i)在[begin, end)上的和，LANES个累加器
+    template <Method M, typename F>
+    Accumulator blockSum(std::int64_t begin, std::int64_t end, const F &f) {
+        double s[LANES] = {0}, c[LANES] = {0};
+        std::int64_t i = begin;
+        for (; i + LANES <= end; i += LANES) {
+            for (int l = 0; l < LANES; ++l) {
+                const double x = f(i + l);
+                if constexpr (M == Method::Kahan) {
+                    const double y = x - c[l];
+                    const double t = s[l] + y;
+                    c[l] = (t - s[l]) - y;
+                    s[l] = t;
+                } else if constexpr (M == Method::Neumaier) {
+                    const double t = s[l] + x;
+                    //用选择而不是分支，各个lane的计算相同，编译器可以向量化
+                    const double big = std::abs(s[l]) >= std::abs(x) ? s[l] : x;
+                    const double small = std::abs(s[l]) >= std::abs(x) ? x : s[l];
+                    c[l] += (big - t) + small;
+                    s[l] = t;
+                } else {
+                    s[l] += x;
+                }
+            }
+        }
+        Accumulator acc = mergeLanes<M>(s, c);
+        for (; i < end; ++i) {
+            combine<M>(acc, Accumulator{f(i), 0.0});
+        }
+        return acc;
+    }
+
+    //两两求和：长度大于PAIRWISE_BASE时对半分，各自求和后相加
+    template <typename F>
+    double pairwiseSum(std::int64_t begin, std::int64_t end, const F &f) {
+        if (end - begin <= PAIRWISE_BASE) {
+            return blockSum<Method::Naive>(begin, end, f).result();
+        }
+        const std::int64_t mid = begin + (end - begin) / 2;
+        return pairwiseSum(begin, mid, f) + pairwiseSum(mid, end, f);
+    }
+
+    template <Method M, typename F>
+    Accumulator rangeSum(std::int64_t begin, std::int64_t end, const F &f) {
+        if constexpr (M == Method::Pairwise) {
+            return Accumulator{pairwiseSum(begin, end, f), 0.0};
+        } else {
+            return blockSum<M>(begin, end, f);
+        }
+    }
+
+    //[0, n)按BLOCK_SIZE分块，block(begin, end)返回一块的Accumulator，各块的结果按M合并
+    template <Method M, typename Block>
+    double sumBlocks(std::int64_t n, const Block &block, bool deterministic = true) {
+        const std::int64_t num_blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        auto leaf = [n, &block](const tbb::blocked_range<std::int64_t> &r, Accumulator acc) -> Accumulator {
+            for (std::int64_t b = r.begin(); b != r.end(); ++b) {
+                combine<M>(acc, block(b * BLOCK_SIZE, std::min(n, (b + 1) * BLOCK_SIZE)));
+            }
+            return acc;
+        };
+        auto join = [](Accumulator a, const Accumulator &b) -> Accumulator {
+            combine<M>(a, b);
+            return a;
+        };
+        const tbb::blocked_range<std::int64_t> blocks(0, num_blocks, 1);
+        Accumulator total = deterministic
+                            ? tbb::parallel_deterministic_reduce(blocks, Accumulator(), leaf, join)
+                            : tbb::parallel_reduce(blocks, Accumulator(), leaf, join);
+        return total.result();
+    }
+
+    //f(i)（i在[0, n)）的和
+    template <Method M, typename F>
+    double sum(std::int64_t n, F f, bool deterministic = true) {
+        return sumBlocks<M>(n, [&f](std::int64_t begin, std::int64_t end) { return rangeSum<M>(begin, end, f); },
+                            deterministic);
+    }
+
+    //数组求和
+    template <Method M>
+    double sum(const double *a, std::size_t n, bool deterministic = true) {
+        return sum<M>((std::int64_t) n, [a](std::int64_t i) { return a[i]; }, deterministic);
+    }
+
+    inline const char *methodName(Method m) {
+        switch (m) {
+            case Method::Naive: return "naive";
+            case Method::Kahan: return "kahan";
+            case Method::Neumaier: return "neumaier";
+            case Method::Pairwise: return "pairwise";
+        }
+        return "";
+    }
+
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <tbb/tbb.h>
+
+//一趟并行计算多个统计量
+//Reducer<S1, S2, ...>在编译期组合需要的统计量，没选的统计量不产生任何代码和开销
+//每个统计量S提供：
+//  void addBlock(const T *a, std::size_t n)：累加一块数据
+//  void merge(const S &other)：合并另一部分的结果（parallel_reduce的join）
+//数据按块（BLOCK_SIZE个元素，能留在L2里）处理，每块依次交给各个统计量，
+//所以整个数组只从内存读一次，各统计量的内层循环各自简单、可以向量化
+namespace Stats {
+
+    const std::size_t BLOCK_SIZE = 1 << 13;
+    const int LANES = 8;
+
+    //lane累加的和，其他统计量也用
+    template <typename T>
+    double blockSum(const T *a, std::size_t n) {
+        double s[LANES] = {0};
+        std::size_t i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            for (int l = 0; l < LANES; ++l) {
+                s[l] += (double) a[i + l];
+            }
+        }
+        double sum = 0;
+        for (int l = 0; l < LANES; ++l) {
+            sum += s[l];
+        }
+        for (; i < n; ++i) {
+            sum += (double) a[i];
+        }
+        return sum;
+    }
+
+    struct Count {
+        std::uint64_t count = 0;
+
+        template <typename T>
+        void addBlock(const T *, std::size_t n) { count += n; }
+        void merge(const Count &other) { count += other.count; }
+    };
+
+    struct Sum {
+        double sum = 0;
+
+        template <typename T>
+        void addBlock(const T *a, std::size_t n) { sum += blockSum(a, n); }
+        void merge(const Sum &other) { sum += other.sum; }
+    };
+
+    //均值和方差：块内先求均值再求偏差平方和（数据在cache里，两趟也不多读内存），
+    //块之间和并行的部分之间用Welford/Chan的公式合并，不会像sum(x^2) - n*mean^2那样相消
+    struct Moments {
+        std::uint64_t n = 0;
+        double mean = 0;
+        double m2 = 0;
+
+        template <typename T>
+        void addBlock(const T *a, std::size_t len) {
+            if (len == 0) {
+                return;
+            }
+            const double block_mean = blockSum(a, len) / len;
+            double s[LANES] = {0};
+            std::size_t i = 0;
+            for (; i + LANES <= len; i += LANES) {
+                for (int l = 0; l < LANES; ++l) {
+                    const double d = (double) a[i + l] - block_mean;
+                    s[l] += d * d;
+                }
+            }
+            double block_m2 = 0;
+            for (int l = 0; l < LANES; ++l) {
+                block_m2 += s[l];
+            }
+            for (; i < len; ++i) {
+                const double d = (double) a[i] - block_mean;
+                block_m2 += d * d;
+            }
+            merge(Moments{len, block_mean, block_m2});
+        }
+
+        void merge(const Moments &other) {
+            if (other.n == 0) {
+                return;
+            }
+            const std::uint64_t total = n + other.n;
+            const double delta = other.mean - mean;
+            mean += delta * other.n / total;
+            m2 += other.m2 + delta * delta * ((double) n * other.n / total);
+            n = total;
+        }
+
+        double variance() const { return n > 0 ? m2 / n : 0.0; }
+        double sampleVariance() const { return n > 1 ? m2 / (n - 1) : 0.0; }
+    };
+
+    template <typename V>
+    struct MinMax {
+        //浮点从±inf开始，全是inf的数据也能得到inf
+        V min = std::numeric_limits<V>::has_infinity ? std::numeric_limits<V>::infinity() : std::numeric_limits<V>::max();
+        V max = std::numeric_limits<V>::has_infinity ? -std::numeric_limits<V>::infinity()
+                                                     : std::numeric_limits<V>::lowest();
+
+        template <typename T>
+        void addBlock(const T *a, std::size_t n) {
+            V lo[LANES], hi[LANES];
+            for (int l = 0; l < LANES; ++l) {
+                lo[l] = min;
+                hi[l] = max;
+            }
+            std::size_t i = 0;
+            for (; i + LANES <= n; i += LANES) {
+                for (int l = 0; l < LANES; ++l) {
+                    const V v = (V) a[i + l];
+                    lo[l] = v < lo[l] ? v : lo[l];
+                    hi[l] = v > hi[l] ? v : hi[l];
+                }
+            }
+            for (; i < n; ++i) {
+                const V v = (V) a[i];
+                lo[0] = v < lo[0] ? v : lo[0];
+                hi[0] = v > hi[0] ? v : hi[0];
+            }
+            for (int l = 0; l < LANES; ++l) {
+                min = lo[l] < min ? lo[l] : min;
+                max = hi[l] > max ? hi[l] : max;
+            }
+        }
+        void merge(const MinMax &other) {
+            min = other.min < min ? other.min : min;
+            max = other.max > max ? other.max : max;
+        }
+    };
+
+    //[lo, hi)上等宽的Bins个桶，范围外的分别计入underflow、overflow，NaN计入nan
+    template <int Bins>
+    struct Histogram {
+        double lo = 0;
+        double hi = 1;
+        std::array<std::uint64_t, Bins> counts{};
+        std::uint64_t underflow = 0;
+        std::uint64_t overflow = 0;
+        std::uint64_t nan = 0;
+
+        Histogram() = default;
+        Histogram(double low, double high) : lo(low), hi(high) {}
+
+        template <typename T>
+        void addBlock(const T *a, std::size_t n) {
+            const double scale = Bins / (hi - lo);
+            for (std::size_t i = 0; i < n; ++i) {
+                const double x = (double) a[i];
+                //NaN和任何值比较都是false，必须在转换成下标之前分出去（NaN转int是未定义行为）
+                if (x != x) {
+                    ++nan;
+                } else if (x < lo) {
+                    ++underflow;
+                } else if (x >= hi) {
+                    ++overflow;
+                } else {
+                    ++counts[std::min(Bins - 1, (int) ((x - lo) * scale))];
+                }
+            }
+        }
+        void merge(const Histogram &other) {
+            for (int b = 0; b < Bins; ++b) {
+                counts[b] += other.counts[b];
+            }
+            underflow += other.underflow;
+            overflow += other.overflow;
+            nan += other.nan;
+        }
+    };
+
+    //最大的K个值，用大小为K的小顶堆，只有大于堆顶的元素才需要入堆；NaN不参与（它会破坏堆的顺序）
+    template <typename V, int K>
+    struct TopK {
+        std::array<V, K> heap{};
+        int size = 0;
+
+        template <typename T>
+        void addBlock(const T *a, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                push((V) a[i]);
+            }
+        }
+        void merge(const TopK &other) {
+            for (int k = 0; k < other.size; ++k) {
+                push(other.heap[k]);
+            }
+        }
+        void push(V v) {
+            if (v != v) {
+                return;
+            }
+            if (size < K) {
+                heap[size++] = v;
+                std::push_heap(heap.begin(), heap.begin() + size, std::greater<V>());
+            } else if (v > heap[0]) {
+                std::pop_heap(heap.begin(), heap.end(), std::greater<V>());
+                heap[K - 1] = v;
+                std::push_heap(heap.begin(), heap.end(), std::greater<V>());
+            }
+        }
+        //从大到小
+        std::array<V, K> sorted() const {
+            std::array<V, K> result = heap;
+            std::sort(result.begin(), result.begin() + size, std::greater<V>());
+            return result;
+        }
+    };
+
+    //编译期组合的统计量，各统计量作为基类，用get<S>()取结果
+    template <typename... S>
+    struct Reducer : S... {
+        Reducer() = default;
+        explicit Reducer(const S &... s) : S(s)... {}
+
+        template <typename T>
+        void addBlock(const T *a, std::size_t n) {
+            (S::addBlock(a, n), ...);
+        }
+        void merge(const Reducer &other) {
+            (S::merge(static_cast<const S &>(other)), ...);
+        }
+
+        template <typename X>
+        const X &get() const { return *this; }
+    };
+
+    //一趟并行计算：proto是各统计量的初始状态（例如直方图的范围）
+    template <typename T, typename R>
+    R reduce(const T *a, std::size_t n, const R &proto) {
+        return tbb::parallel_reduce(
+                tbb::blocked_range<std::size_t>(0, n, BLOCK_SIZE), proto,
+                [a](const tbb::blocked_range<std::size_t> &r, R acc) {
+                    for (std::size_t b = r.begin(); b < r.end(); b += BLOCK_SIZE) {
+                        acc.addBlock(a + b, std::min(r.end(), b + BLOCK_SIZE) - b);
+                    }
+                    return acc;
+                },
+                [](R x, const R &y) {
+                    x.merge(y);
+                    return x;
+                });
+    }
+
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tbb/tbb.h>
+#include "FloatReduce.h"
+
+//最值类归约：min、max、minmax、argmin、argmax、平方和，元素类型int、float、double等
+//- 块内用LANES个独立的lane（下标i归第i % LANES个lane），每个lane只做比较+选择，编译器可以向量化；
+//  不够LANES个的尾部单独处理
+//- 带下标的结果按(值, 下标)合并：值相同取下标小的，与分块方式、线程数无关，结果确定
+//- 浮点的NaN不参与比较（所有比较都为假），全是NaN时返回初值（下标为-1）
+namespace MinMax {
+
+    const int LANES = 16;
+    const std::size_t GRAIN_SIZE = 1 << 14;
+
+    //值和它第一次出现的下标，index == -1表示空
+    template <typename T>
+    struct ValueIndex {
+        T value;
+        std::int64_t index;
+    };
+
+    //只有浮点的NaN不等于自身，整数时编译器直接去掉
+    template <typename T>
+    bool isNaN(const T &v) { return !(v == v); }
+
+    //a比b更"好"：Better(a.value, b.value)，或值相同且下标更小
+    template <typename T, typename Better>
+    ValueIndex<T> pick(const ValueIndex<T> &a, const ValueIndex<T> &b, Better better) {
+        if (b.index < 0 || isNaN(b.value)) return a;
+        if (a.index < 0 || isNaN(a.value)) return b;
+        if (better(a.value, b.value)) return a;
+        if (better(b.value, a.value)) return b;
+        return a.index <= b.index ? a : b;
+    }
+
+    struct Less {
+        template <typename T>
+        bool operator()(const T &a, const T &b) const { return a < b; }
+    };
+
+    struct Greater {
+        template <typename T>
+        bool operator()(const T &a, const T &b) const { return a > b; }
+    };
+
+    //块[begin, end)上better意义下的最好元素及其第一次出现的下标
+    template <typename T, typename Better>
+    ValueIndex<T> blockArgBest(const T *a, std::size_t begin, std::size_t end, Better better) {
+        T best[LANES];
+        std::int64_t best_index[LANES];
+        std::size_t i = begin;
+        if (end - begin >= (std::size_t) LANES) {
+            for (int l = 0; l < LANES; ++l) {
+                best[l] = a[i + l];
+                best_index[l] = (std::int64_t) (i + l);
+            }
+            for (i += LANES; i + LANES <= end; i += LANES) {
+                for (int l = 0; l < LANES; ++l) {
+                    //严格更好才替换，lane里保留的是第一次出现的下标；lane的初值是NaN时换掉
+                    const bool take = better(a[i + l], best[l]) || isNaN(best[l]);
+                    best[l] = take ? a[i + l] : best[l];
+                    best_index[l] = take ? (std::int64_t) (i + l) : best_index[l];
+                }
+            }
+        }
+        ValueIndex<T> result{T(), -1};
+        for (int l = 0; l < LANES && begin + LANES <= end; ++l) {
+            result = pick(result, ValueIndex<T>{best[l], best_index[l]}, better);
+        }
+        for (; i < end; ++i) {
+            result = pick(result, ValueIndex<T>{a[i], (std::int64_t) i}, better);
+        }
+        return result;
+    }
+
+    template <typename T, typename Better>
+    ValueIndex<T> argBest(const T *a, std::size_t n, Better better) {
+        return tbb::parallel_reduce(
+                tbb::blocked_range<std::size_t>(0, n, GRAIN_SIZE),
+                ValueIndex<T>{T(), -1},
+                [a, better](const tbb::blocked_range<std::size_t> &r, ValueIndex<T> init) {
+                    return pick(init, blockArgBest(a, r.begin(), r.end(), better), better);
+                },
+                [better](const ValueIndex<T> &x, const ValueIndex<T> &y) { return pick(x, y, better); });
+    }
+
+    template <typename T>
+    ValueIndex<T> argmin(const T *a, std::size_t n) { return argBest(a, n, Less()); }
+
+    template <typename T>
+    ValueIndex<T> argmax(const T *a, std::size_t n) { return argBest(a, n, Greater()); }
+
+    //只要值时不需要下标，每个lane只有一个比较+选择
+    template <typename T, typename Better>
+    T blockBest(const T *a, std::size_t begin, std::size_t end, T init, Better better) {
+        T best[LANES];
+        for (int l = 0; l < LANES; ++l) {
+            best[l] = init;
+        }
+        std::size_t i = begin;
+        for (; i + LANES <= end; i += LANES) {
+            for (int l = 0; l < LANES; ++l) {
+                best[l] = better(a[i + l], best[l]) ? a[i + l] : best[l];
+            }
+        }
+        for (; i < end; ++i) {
+            best[0] = better(a[i], best[0]) ? a[i] : best[0];
+        }
+        T result = init;
+        for (int l = 0; l < LANES; ++l) {
+            result = better(best[l], result) ? best[l] : result;
+        }
+        return result;
+    }
+
+    template <typename T, typename Better>
+    T best(const T *a, std::size_t n, T init, Better better) {
+        return tbb::parallel_reduce(
+                tbb::blocked_range<std::size_t>(0, n, GRAIN_SIZE), init,
+                [a, better](const tbb::blocked_range<std::size_t> &r, T v) {
+                    return blockBest(a, r.begin(), r.end(), v, better);
+                },
+                [better](T x, T y) { return better(y, x) ? y : x; });
+    }
+
+    //min、max的初值：浮点用±inf，否则全是+inf时min会返回类型的最大值；整数用最大值、最小值
+    template <typename T>
+    T minSeed() {
+        return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    }
+
+    template <typename T>
+    T maxSeed() {
+        return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity()
+                                                    : std::numeric_limits<T>::lowest();
+    }
+
+    //空序列时返回初值：min是+inf（整数是最大值），max是-inf（整数是最小值）
+    template <typename T>
+    T min(const T *a, std::size_t n) { return best(a, n, minSeed<T>(), Less()); }
+
+    template <typename T>
+    T max(const T *a, std::size_t n) { return best(a, n, maxSeed<T>(), Greater()); }
+
+    template <typename T>
+    struct MinMaxResult {
+        T min;
+        T max;
+    };
+
+    //一趟同时求最小值和最大值，每个元素只读一次
+    template <typename T>
+    MinMaxResult<T> minmax(const T *a, std::size_t n) {
+        const MinMaxResult<T> init{minSeed<T>(), maxSeed<T>()};
+        return tbb::parallel_reduce(
+                tbb::blocked_range<std::size_t>(0, n, GRAIN_SIZE), init,
+                [a](const tbb::blocked_range<std::size_t> &r, MinMaxResult<T> v) {
+                    T lo[LANES], hi[LANES];
+                    for (int l = 0; l < LANES; ++l) {
+                        lo[l] = v.min;
+                        hi[l] = v.max;
+                    }
+                    std::size_t i = r.begin();
+                    for (; i + LANES <= r.end(); i += LANES) {
+                        for (int l = 0; l < LANES; ++l) {
+                            lo[l] = a[i + l] < lo[l] ? a[i + l] : lo[l];
+                            hi[l] = a[i + l] > hi[l] ? a[i + l] : hi[l];
+                        }
+                    }
+                    for (; i < r.end(); ++i) {
+                        lo[0] = a[i] < lo[0] ? a[i] : lo[0];
+                        hi[0] = a[i] > hi[0] ? a[i] : hi[0];
+                    }
+                    for (int l = 0; l < LANES; ++l) {
+                        v.min = lo[l] < v.min ? lo[l] : v.min;
+                        v.max = hi[l] > v.max ? hi[l] : v.max;
+                    }
+                    return v;
+                },
+                [](const MinMaxResult<T> &x, const MinMaxResult<T> &y) {
+                    return MinMaxResult<T>{y.min < x.min ? y.min : x.min, y.max > x.max ? y.max : x.max};
+                });
+    }
+
+    //平方和，用double累加（整数的平方和也可能超出64位），复用FloatReduce的确定性分块求和
+    template <typename T>
+    double sumOfSquares(const T *a, std::size_t n) {
+        return FloatReduce::sum<FloatReduce::Method::Naive>((std::int64_t) n, [a](std::int64_t i) {
+            const double x = (double) a[i];
+            return x * x;
+        });
+    }
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <tbb/tbb.h>
+#include "FloatReduce.h"
+
+//数值积分（calcPI的推广）：被积函数是模板参数（函数对象、lambda），调用可以内联
+//- 复合求积：[a, b]等分成n个（64位）小区间，每个小区间用一个求积公式，
+//  小区间的和用FloatReduce::sum：块内LANES个独立累加器，被积函数内联后整个循环可以向量化，结果与线程数无关
+//- 自适应：比较整个区间和两个半区间的结果估计误差，误差大的区间二分，两半作为并行任务继续
+namespace Quadrature {
+
+    //中点公式，每个小区间1次求值，误差O(h^2)
+    struct Midpoint {
+        static constexpr int ORDER = 2;
+        template <typename F>
+        static double panel(const F &f, double x, double h) { return f(x + 0.5 * h) * h; }
+    };
+
+    //Simpson公式，误差O(h^4)；复合时相邻小区间共用端点，每个小区间2次求值
+    struct Simpson {
+        static constexpr int ORDER = 4;
+        template <typename F>
+        static double panel(const F &f, double x, double h) {
+            return (f(x) + 4 * f(x + 0.5 * h) + f(x + h)) * (h / 6);
+        }
+    };
+
+    //N点Gauss–Legendre的节点和权重（[-1, 1]上）
+    template <int N>
+    struct GaussNodes;
+
+    template <>
+    struct GaussNodes<2> {
+        static constexpr double NODES[2] = {-0.57735026918962576451, 0.57735026918962576451};
+        static constexpr double WEIGHTS[2] = {1.0, 1.0};
+    };
+
+    template <>
+    struct GaussNodes<3> {
+        static constexpr double NODES[3] = {-0.77459666924148337704, 0.0, 0.77459666924148337704};
+        static constexpr double WEIGHTS[3] = {0.55555555555555555556, 0.88888888888888888889, 0.55555555555555555556};
+    };
+
+    template <>
+    struct GaussNodes<4> {
+        static constexpr double NODES[4] = {-0.86113631159405257522, -0.33998104358485626480,
+                                            0.33998104358485626480, 0.86113631159405257522};
+        static constexpr double WEIGHTS[4] = {0.34785484513745385737, 0.65214515486254614263,
+                                              0.65214515486254614263, 0.34785484513745385737};
+    };
+
+    template <>
+    struct GaussNodes<5> {
+        static constexpr double NODES[5] = {-0.90617984593866399280, -0.53846931010568309104, 0.0,
+                                            0.53846931010568309104, 0.90617984593866399280};
+        static constexpr double WEIGHTS[5] = {0.23692688505618908751, 0.47862867049936646804,
+                                              0.56888888888888888889, 0.47862867049936646804,
+                                              0.23692688505618908751};
+    };
+
+    //N点Gauss–Legendre公式，每个小区间N次求值，误差O(h^(2N))；N是编译期常量，循环完全展开
+    template <int N>
+    struct GaussLegendre {
+        static constexpr int ORDER = 2 * N;
+        template <typename F>
+        static double panel(const F &f, double x, double h) {
+            const double half = 0.5 * h, center = x + half;
+            double s = 0;
+            for (int k = 0; k < N; ++k) {
+                s += GaussNodes<N>::WEIGHTS[k] * f(center + half * GaussNodes<N>::NODES[k]);
+            }
+            return s * half;
+        }
+    };
+
+    //复合求积：[a, b]等分成n个小区间
+    template <typename Rule, FloatReduce::Method M = FloatReduce::Method::Naive, typename F>
+    double integrate(const F &f, double a, double b, std::int64_t n) {
+        const double h = (b - a) / n;
+        if constexpr (std::is_same<Rule, Simpson>::value) {
+            //每个小区间算左端点（权重2/6）和中点（权重4/6），最后补上两端各差的1/6
+            double s = FloatReduce::sum<M>(n, [&f, a, h](std::int64_t i) {
+                const double x = a + i * h;
+                return 2 * f(x) + 4 * f(x + 0.5 * h);
+            });
+            return (s + f(b) - f(a)) * (h / 6);
+        } else {
+            return FloatReduce::sum<M>(n, [&f, a, h](std::int64_t i) { return Rule::panel(f, a + i * h, h); });
+        }
+    }
+
+    struct Result {
+        double value = 0;
+        double error = 0;           //各区间误差估计之和
+        std::int64_t panels = 0;    //最终使用的小区间个数
+    };
+
+    //递归深度达到这个值后不再生成任务，子区间串行递归
+    const int SPAWN_DEPTH = 16;
+    //二分的最大深度，奇点附近达到后就接受当前结果
+    const int MAX_DEPTH = 50;
+
+    template <typename Rule, typename F>
+    Result adaptiveImpl(const F &f, double a, double b, double whole, double tol, int depth) {
+        const double m = 0.5 * (a + b);
+        const double left = Rule::panel(f, a, m - a), right = Rule::panel(f, m, b - m);
+        //两半的和比整个区间精确得多，差值近似为整个区间的误差；
+        //光滑时两半的误差只有它的1/(2^ORDER - 1)，但在导数奇异处会低估，这里直接用差值，偏保守
+        const double error = std::abs(left + right - whole);
+        if (error <= tol || depth >= MAX_DEPTH) {
+            return Result{left + right, error, 2};
+        }
+        Result l, r;
+        if (depth < SPAWN_DEPTH) {
+            tbb::parallel_invoke([&] { l = adaptiveImpl<Rule>(f, a, m, left, tol / 2, depth + 1); },
+                                 [&] { r = adaptiveImpl<Rule>(f, m, b, right, tol / 2, depth + 1); });
+        } else {
+            l = adaptiveImpl<Rule>(f, a, m, left, tol / 2, depth + 1);
+            r = adaptiveImpl<Rule>(f, m, b, right, tol / 2, depth + 1);
+        }
+        return Result{l.value + r.value, l.error + r.error, l.panels + r.panels};
+    }
+
+    //自适应积分：估计的绝对误差不超过tol
+    template <typename Rule = GaussLegendre<5>, typename F>
+    Result adaptive(const F &f, double a, double b, double tol) {
+        return adaptiveImpl<Rule>(f, a, b, Rule::panel(f, a, b - a), tol, 0);
+    }
+
+}
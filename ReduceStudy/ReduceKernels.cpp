@@ -0,0 +1,67 @@
+#include <cmath>
+#include <cstdint>
+#include "DispatchVariant.h"
+//ISA编译时不包含ReduceKernels.h：FloatReduce.h带着tbb的头文件，其中的inline函数会在ISA目标文件里各生成一份，
+//链接器可能留下AVX-512的那份
+#if SAMPLES_ISA_LEVEL == 0
+#include "ReduceKernels.h"
+#endif
+
+//这个文件按不同的ISA编译多次，见DispatchVariant.h
+namespace ReduceKernels {
+    namespace SAMPLES_ISA_NS {
+
+        //和FloatReduce::LANES相同，默认编译时检查
+        const int LANES = 8;
+        enum class Method { Naive, Kahan, Neumaier };
+
+        //和FloatReduce::blockSum的整批部分相同
+        template <Method M>
+        void laneSum(const double *a, std::int64_t n, double *s_out, double *c_out) {
+            double s[LANES] = {0}, c[LANES] = {0};
+            for (std::int64_t i = 0; i < n; i += LANES) {
+                for (int l = 0; l < LANES; ++l) {
+                    const double x = a[i + l];
+                    if constexpr (M == Method::Kahan) {
+                        const double y = x - c[l];
+                        const double t = s[l] + y;
+                        c[l] = (t - s[l]) - y;
+                        s[l] = t;
+                    } else if constexpr (M == Method::Neumaier) {
+                        const double t = s[l] + x;
+                        const double big = std::abs(s[l]) >= std::abs(x) ? s[l] : x;
+                        const double small = std::abs(s[l]) >= std::abs(x) ? x : s[l];
+                        c[l] += (big - t) + small;
+                        s[l] = t;
+                    } else {
+                        s[l] += x;
+                    }
+                }
+            }
+            for (int l = 0; l < LANES; ++l) {
+                s_out[l] = s[l];
+                c_out[l] = c[l];
+            }
+        }
+        void laneSumNaive(const double *a, std::int64_t n, double *s, double *c) {
+            laneSum<Method::Naive>(a, n, s, c);
+        }
+
+        void laneSumKahan(const double *a, std::int64_t n, double *s, double *c) {
+            laneSum<Method::Kahan>(a, n, s, c);
+        }
+
+        void laneSumNeumaier(const double *a, std::int64_t n, double *s, double *c) {
+            laneSum<Method::Neumaier>(a, n, s, c);
+        }
+
+    }
+
+#if SAMPLES_ISA_LEVEL == 0
+    static_assert(scalar::LANES == FloatReduce::LANES, "lane count differs from FloatReduce");
+#endif
+
+    SAMPLES_KERNEL(LaneSum, naiveKernel, "sumNaive", laneSumNaive);
+    SAMPLES_KERNEL(LaneSum, kahanKernel, "sumKahan", laneSumKahan);
+    SAMPLES_KERNEL(LaneSum, neumaierKernel, "sumNeumaier", laneSumNeumaier);
+}
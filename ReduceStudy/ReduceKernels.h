@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Dispatch.h"
+#include "FloatReduce.h"
+
+//数组求和的块内kernel：FloatReduce::blockSum的LANES个累加器循环，按方法各一个kernel
+//ReduceKernels.cpp按ISA编译多次，调用时Dispatch按CPU选版本；各版本不用FMA，结果和FloatReduce::sum逐位相同
+namespace ReduceKernels {
+
+    //a[0, n)（n是LANES的整数倍）分到LANES个累加器：s[l]是和，c[l]是补偿项（Naive时为0）
+    using LaneSum = void (*)(const double *a, std::int64_t n, double *s, double *c);
+
+    //定义在ReduceKernels.cpp的默认编译里（SAMPLES_KERNEL）
+    Dispatch::Kernel<LaneSum> &naiveKernel();
+    Dispatch::Kernel<LaneSum> &kahanKernel();
+    Dispatch::Kernel<LaneSum> &neumaierKernel();
+
+    template <FloatReduce::Method M>
+    Dispatch::Kernel<LaneSum> &laneSumKernel() {
+        static_assert(M != FloatReduce::Method::Pairwise, "pairwise sum has no lane kernel");
+        if constexpr (M == FloatReduce::Method::Naive) {
+            return naiveKernel();
+        } else if constexpr (M == FloatReduce::Method::Kahan) {
+            return kahanKernel();
+        } else {
+            return neumaierKernel();
+        }
+    }
+
+    //和FloatReduce::sum<M>(a, n, deterministic)相同，块内循环用指定的版本lanes（比较各版本时用）
+    template <FloatReduce::Method M>
+    double sum(LaneSum lanes, const double *a, std::size_t n, bool deterministic = true) {
+        using namespace FloatReduce;
+        static_assert(M != Method::Pairwise, "pairwise sum has no lane kernel");
+        auto block = [a, lanes](std::int64_t begin, std::int64_t end) {
+            double s[LANES], c[LANES];
+            const std::int64_t full = (end - begin) / LANES * LANES;
+            lanes(a + begin, full, s, c);
+            Accumulator acc = mergeLanes<M>(s, c);
+            for (std::int64_t i = begin + full; i < end; ++i) {
+                combine<M>(acc, Accumulator{a[i], 0.0});
+            }
+            return acc;
+        };
+        return sumBlocks<M>((std::int64_t) n, block, deterministic);
+    }
+
+    //块内循环用按CPU选的版本；Pairwise是递归的，直接用FloatReduce
+    template <FloatReduce::Method M>
+    double sum(const double *a, std::size_t n, bool deterministic = true) {
+        if constexpr (M == FloatReduce::Method::Pairwise) {
+            return FloatReduce::sum<M>(a, n, deterministic);
+        } else {
+            return sum<M>(laneSumKernel<M>().get(), a, n, deterministic);
+        }
+    }
+
+}
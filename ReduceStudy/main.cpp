@@ -1,6 +1,18 @@
 #include <iostream>
 #include <vector>
+#include <random>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <cstdint>
 #include <tbb/tbb.h>
+#include "FloatReduce.h"
+#include "MinMaxReduce.h"
+#include "FusedStats.h"
+#include "Quadrature.h"
+#include "ReduceKernels.h"
 
 //求最大值
 int pmax(const std::vector<int> &arr){
@@ -41,9 +53,365 @@ double calcPI(int degree){
     return 4 * sum;
 }
 
+//求pi，可选求和方法；区间个数是64位的，deterministic时结果与线程数无关
+template <FloatReduce::Method M>
+double calcPI(std::int64_t degree, bool deterministic){
+    const double dx = 1.0 / degree;
+    return 4 * FloatReduce::sum<M>(degree, [dx](std::int64_t i){
+        double x = (i + 0.5) * dx;
+        return std::sqrt(1 - x * x) * dx;
+    }, deterministic);
+}
+
+//各求和方法的误差、耗时，以及不同线程数下结果是否逐位相同
+template <FloatReduce::Method M>
+void comparePI(std::int64_t degree){
+    const double pi = 3.14159265358979323846;
+    double first = 0;
+    bool reproducible = true, nondet_reproducible = true;
+    double first_nondet = 0, time = 0;
+    for(int threads : {1, 2, 3, 4, 8}){
+        tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+        tbb::tick_count t0 = tbb::tick_count::now();
+        double v = calcPI<M>(degree, true);
+        if(threads == 1){
+            time = (tbb::tick_count::now() - t0).seconds();
+            first = v;
+        }
+        reproducible &= v == first;
+        double w = calcPI<M>(degree, false);
+        if(threads == 1){
+            first_nondet = w;
+        }
+        nondet_reproducible &= w == first_nondet;
+    }
+    std::cout << std::setw(10) << FloatReduce::methodName(M) << ": PI = " << std::setprecision(17) << first
+              << ", error " << std::setprecision(3) << std::abs(first - pi) << ", " << time << " s"
+              << ", deterministic across threads: " << (reproducible ? "yes" : "NO")
+              << ", parallel_reduce: " << (nondet_reproducible ? "same" : "differs") << std::endl;
+}
+
+//数组求和的舍入误差：元素跨越多个数量级、正负相消，参考值用long double按绝对值从小到大累加
+template <FloatReduce::Method M>
+void compareArraySum(const std::vector<double> &a, long double reference){
+    tbb::tick_count t0 = tbb::tick_count::now();
+    double v = FloatReduce::sum<M>(a.data(), a.size());
+    double time = (tbb::tick_count::now() - t0).seconds();
+    std::cout << std::setw(10) << FloatReduce::methodName(M) << ": relative error " << std::setprecision(3)
+              << (double)std::abs((v - reference) / reference) << ", " << time << " s";
+    //块内循环换成按CPU选版本的kernel计时；本机CPU支持的每个版本的结果都应该和FloatReduce逐位相同
+    if constexpr (M != FloatReduce::Method::Pairwise){
+        auto &kernel = ReduceKernels::laneSumKernel<M>();
+        t0 = tbb::tick_count::now();
+        ReduceKernels::sum<M>(a.data(), a.size());
+        time = (tbb::tick_count::now() - t0).seconds();
+        std::cout << ", kernel (" << Dispatch::isaName(kernel.selected()) << ") " << time << " s, check";
+        for(int i = 0; i <= (int)Dispatch::detectIsa(); ++i){
+            const auto isa = (Dispatch::Isa)i;
+            if(kernel.variant(isa) == nullptr){
+                continue;
+            }
+            double k = ReduceKernels::sum<M>(kernel.variant(isa), a.data(), a.size());
+            std::cout << " " << Dispatch::isaName(isa) << (k == v ? " ok" : " MISMATCH");
+        }
+    }
+    std::cout << std::endl;
+}
+
+void testArraySum(){
+    const std::size_t n = 1 << 24;
+    std::vector<double> a(n);
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> mantissa(1.0, 2.0);
+    for(auto &x : a){
+        x = std::ldexp(mantissa(rng), (int)(rng() % 60) - 30) * ((rng() & 1) ? 1 : -1);
+    }
+    std::vector<double> sorted = a;
+    std::sort(sorted.begin(), sorted.end(), [](double x, double y){ return std::abs(x) < std::abs(y); });
+    long double reference = 0;
+    for(double x : sorted){
+        reference += x;
+    }
+    compareArraySum<FloatReduce::Method::Naive>(a, reference);
+    compareArraySum<FloatReduce::Method::Kahan>(a, reference);
+    compareArraySum<FloatReduce::Method::Neumaier>(a, reference);
+    compareArraySum<FloatReduce::Method::Pairwise>(a, reference);
+}
+
+//最值归约：与std::min_element/max_element（都返回第一次出现的位置）比较，元素个数不是LANES的整数倍
+template <typename T>
+bool checkMinMax(const char *name, std::size_t n){
+    std::vector<T> a(n);
+    std::mt19937_64 rng(n);
+    for(auto &x : a){
+        x = (T)(rng() % 1000000) - (T)500000;
+    }
+    //最大值、最小值各出现多次，检查取第一次出现的下标
+    for(std::size_t k = 1; k <= 3 && n > 0; ++k){
+        a[n * k / 4] = (T)600000;
+        a[n * k / 5] = (T)-600000;
+    }
+    if(std::is_floating_point<T>::value && n > 10){
+        a[n / 7] = std::numeric_limits<T>::quiet_NaN();
+    }
+    bool ok = true;
+    if(n > 0){
+        //NaN不参与比较，std::max_element/min_element用的也是<，NaN不会被选中（除非在第一个）
+        auto gold_max = std::max_element(a.begin(), a.end());
+        auto gold_min = std::min_element(a.begin(), a.end());
+        auto arg_max = MinMax::argmax(a.data(), n);
+        auto arg_min = MinMax::argmin(a.data(), n);
+        auto mm = MinMax::minmax(a.data(), n);
+        ok &= arg_max.index == gold_max - a.begin() && arg_max.value == *gold_max;
+        ok &= arg_min.index == gold_min - a.begin() && arg_min.value == *gold_min;
+        ok &= MinMax::max(a.data(), n) == *gold_max && MinMax::min(a.data(), n) == *gold_min;
+        ok &= mm.max == *gold_max && mm.min == *gold_min;
+    }
+    //平方和：与long double串行累加比较；非负项朴素求和的相对误差不超过n * eps(double)
+    //含NaN时结果是NaN，浮点类型另外在去掉NaN的副本上比较
+    std::vector<T> finite = a;
+    long double gold_sq = 0;
+    for(T &x : finite){
+        if(x != x){
+            x = 0;
+        }
+        gold_sq += (long double)x * x;
+    }
+    const double sq_tolerance = std::max(1e-12, (double)n * std::numeric_limits<double>::epsilon());
+    ok &= std::abs((double)((MinMax::sumOfSquares(finite.data(), n) - gold_sq) / std::max(gold_sq, 1.0L))) < sq_tolerance;
+    if(std::is_floating_point<T>::value && n > 10){
+        const double sq = MinMax::sumOfSquares(a.data(), n);
+        ok &= sq != sq;
+    }
+    if(!ok){
+        std::cerr << "  MinMax " << name << " n=" << n << " failed" << std::endl;
+    }
+    return ok;
+}
+
+//全是+inf或-inf时最值就是inf，不能是初值（类型的最大值、最小值）
+template <typename T>
+bool checkInfinity(const char *name, std::size_t n){
+    const T inf = std::numeric_limits<T>::infinity();
+    bool ok = true;
+    for(T v : {inf, -inf}){
+        std::vector<T> a(n, v);
+        const auto mm = MinMax::minmax(a.data(), n);
+        const auto fused = Stats::reduce(a.data(), n, Stats::Reducer<Stats::MinMax<T>>());
+        ok &= MinMax::min(a.data(), n) == v && MinMax::max(a.data(), n) == v && mm.min == v && mm.max == v;
+        ok &= fused.min == v && fused.max == v;
+    }
+    //混合：最小值是-inf，最大值是+inf，其余有限
+    if(n > 2){
+        std::vector<T> a(n, (T)1);
+        a[n / 3] = -inf;
+        a[n / 2] = inf;
+        const auto mm = MinMax::minmax(a.data(), n);
+        ok &= MinMax::min(a.data(), n) == -inf && MinMax::max(a.data(), n) == inf && mm.min == -inf && mm.max == inf;
+    }
+    if(!ok){
+        std::cerr << "  MinMax " << name << " n=" << n << " with infinities failed" << std::endl;
+    }
+    return ok;
+}
+
+void testMinMax(){
+    bool ok = true;
+    for(std::size_t n : {1, 15, 17, 1000, 100003, 10000019}){
+        ok &= checkMinMax<int>("int", n);
+        ok &= checkMinMax<float>("float", n);
+        ok &= checkMinMax<double>("double", n);
+        ok &= checkInfinity<float>("float", n);
+        ok &= checkInfinity<double>("double", n);
+    }
+    std::cout << "MinMax tests " << (ok ? "passed" : "FAILED") << std::endl;
+
+    std::vector<int> a(1 << 26);
+    for(std::size_t i = 0; i < a.size(); ++i){
+        a[i] = (int)((i * 2654435761u) >> 4);
+    }
+    tbb::tick_count t0 = tbb::tick_count::now();
+    int m1 = pmax(a);
+    double t_pmax = (tbb::tick_count::now() - t0).seconds();
+    t0 = tbb::tick_count::now();
+    int m2 = MinMax::max(a.data(), a.size());
+    double t_max = (tbb::tick_count::now() - t0).seconds();
+    t0 = tbb::tick_count::now();
+    auto am = MinMax::argmax(a.data(), a.size());
+    double t_argmax = (tbb::tick_count::now() - t0).seconds();
+    std::cout << "max of " << a.size() << " ints: pmax " << t_pmax << " s, MinMax::max " << t_max
+              << " s, MinMax::argmax " << t_argmax << " s" << (m1 == m2 && am.value == m1 ? "" : " MISMATCH") << std::endl;
+}
+
+//一趟多统计量：与串行的两趟结果比较；数据加了很大的偏移，检查方差没有相消
+void testFusedStats(){
+    const std::size_t n = 20000003;
+    std::vector<double> a(n);
+    std::mt19937_64 rng(43);
+    std::normal_distribution<double> normal(0.0, 3.0);
+    for(auto &x : a){
+        x = 1e8 + normal(rng);
+    }
+    using All = Stats::Reducer<Stats::Count, Stats::Sum, Stats::Moments, Stats::MinMax<double>,
+                               Stats::Histogram<64>, Stats::TopK<double, 10>>;
+    const All proto(Stats::Count(), Stats::Sum(), Stats::Moments(), Stats::MinMax<double>(),
+                    Stats::Histogram<64>(1e8 - 12, 1e8 + 12), Stats::TopK<double, 10>());
+    tbb::tick_count t0 = tbb::tick_count::now();
+    const All all = Stats::reduce(a.data(), n, proto);
+    double t_fused = (tbb::tick_count::now() - t0).seconds();
+
+    //参照：long double两趟
+    long double gold_sum = 0;
+    for(double x : a){
+        gold_sum += x;
+    }
+    const long double gold_mean = gold_sum / n;
+    long double gold_m2 = 0;
+    for(double x : a){
+        gold_m2 += (x - gold_mean) * (x - gold_mean);
+    }
+    const double gold_var = (double)(gold_m2 / n);
+    auto gold_mm = std::minmax_element(a.begin(), a.end());
+    std::vector<double> top(a);
+    std::partial_sort(top.begin(), top.begin() + 10, top.end(), std::greater<double>());
+    //朴素公式E[x^2] - E[x]^2作对比
+    long double sq = 0;
+    for(double x : a){
+        sq += (double)x * x;
+    }
+    const double naive_var = (double)(sq / n) - (double)(gold_sum / n) * (double)(gold_sum / n);
+
+    const auto &moments = all.get<Stats::Moments>();
+    const auto &hist = all.get<Stats::Histogram<64>>();
+    std::uint64_t hist_total = hist.underflow + hist.overflow + hist.nan;
+    for(auto c : hist.counts){
+        hist_total += c;
+    }
+    const auto top10 = all.get<Stats::TopK<double, 10>>().sorted();
+    bool ok = all.get<Stats::Count>().count == n && hist_total == n;
+    ok &= std::abs((double)(all.get<Stats::Sum>().sum - gold_sum)) < 1e-9 * (double)gold_sum;
+    ok &= std::abs(moments.mean - (double)gold_mean) < 1e-6;
+    ok &= std::abs(moments.variance() - gold_var) < 1e-9 * gold_var;
+    ok &= all.get<Stats::MinMax<double>>().min == *gold_mm.first && all.get<Stats::MinMax<double>>().max == *gold_mm.second;
+    ok &= std::equal(top10.begin(), top10.end(), top.begin());
+    ok &= hist.nan == 0;
+
+    //含NaN的数据：直方图把NaN单独计数，最值和TopK跳过NaN
+    std::vector<double> with_nan = {3.0, std::numeric_limits<double>::quiet_NaN(), -1.0, 0.5,
+                                    std::numeric_limits<double>::quiet_NaN(), 7.0, 2.0};
+    using NanStats = Stats::Reducer<Stats::Count, Stats::MinMax<double>, Stats::Histogram<4>, Stats::TopK<double, 3>>;
+    const NanStats nan_stats = Stats::reduce(with_nan.data(), with_nan.size(),
+                                             NanStats(Stats::Count(), Stats::MinMax<double>(), Stats::Histogram<4>(0, 4),
+                                                      Stats::TopK<double, 3>()));
+    const auto &nan_hist = nan_stats.get<Stats::Histogram<4>>();
+    const auto nan_top = nan_stats.get<Stats::TopK<double, 3>>();
+    ok &= nan_hist.nan == 2 && nan_hist.underflow == 1 && nan_hist.overflow == 1;
+    ok &= nan_hist.counts[0] == 1 && nan_hist.counts[1] == 0 && nan_hist.counts[2] == 1 && nan_hist.counts[3] == 1;
+    ok &= nan_stats.get<Stats::MinMax<double>>().min == -1.0 && nan_stats.get<Stats::MinMax<double>>().max == 7.0;
+    ok &= nan_top.size == 3 && nan_top.sorted()[0] == 7.0 && nan_top.sorted()[1] == 3.0 && nan_top.sorted()[2] == 2.0;
+    std::cout << "FusedStats tests " << (ok ? "passed" : "FAILED") << ", variance " << moments.variance()
+              << " (reference " << gold_var << ", E[x^2]-E[x]^2 gives " << naive_var << ")" << std::endl;
+
+    //每个统计量单独一趟，对比一趟全做
+    t0 = tbb::tick_count::now();
+    Stats::reduce(a.data(), n, Stats::Reducer<Stats::Count>());
+    Stats::reduce(a.data(), n, Stats::Reducer<Stats::Sum>());
+    Stats::reduce(a.data(), n, Stats::Reducer<Stats::Moments>());
+    Stats::reduce(a.data(), n, Stats::Reducer<Stats::MinMax<double>>());
+    Stats::reduce(a.data(), n, Stats::Reducer<Stats::Histogram<64>>(Stats::Histogram<64>(1e8 - 12, 1e8 + 12)));
+    Stats::reduce(a.data(), n, Stats::Reducer<Stats::TopK<double, 10>>());
+    double t_separate = (tbb::tick_count::now() - t0).seconds();
+    //只选Sum时和手写的求和一样
+    t0 = tbb::tick_count::now();
+    double s = Stats::reduce(a.data(), n, Stats::Reducer<Stats::Sum>()).sum;
+    double t_sum = (tbb::tick_count::now() - t0).seconds();
+    std::cout << "stats of " << n << " doubles: fused " << t_fused << " s, separate passes " << t_separate
+              << " s, sum only " << t_sum << " s (" << s / n << ")" << std::endl;
+}
+
+//积分的测试函数：函数对象，积分区间和精确值
+struct QuarterCircle{
+    double operator()(double x) const { return 4 * std::sqrt(std::max(0.0, 1 - x * x)); }
+    static constexpr const char *NAME = "4sqrt(1-x^2) on [0,1]";
+    static constexpr double A = 0, B = 1;
+    static double exact(){ return 3.14159265358979323846; }
+};
+
+struct Gaussian{
+    double operator()(double x) const { return std::exp(-x * x); }
+    static constexpr const char *NAME = "exp(-x^2) on [0,3]";
+    static constexpr double A = 0, B = 3;
+    static double exact(){ return 0.88622692545275801365 * std::erf(3.0); }
+};
+
+struct Runge{
+    double operator()(double x) const { return 1 / (1 + 25 * x * x); }
+    static constexpr const char *NAME = "1/(1+25x^2) on [-1,1]";
+    static constexpr double A = -1, B = 1;
+    static double exact(){ return 0.4 * std::atan(5.0); }
+};
+
+struct Oscillatory{
+    double operator()(double x) const { return std::cos(50 * x); }
+    static constexpr const char *NAME = "cos(50x) on [0,1]";
+    static constexpr double A = 0, B = 1;
+    static double exact(){ return std::sin(50.0) / 50; }
+};
+
+//收敛性：区间个数每次乘10，各求积公式的误差；最后一列是GL5在最大n时的耗时
+template <typename F>
+void convergence(){
+    const F f;
+    std::cout << F::NAME << std::endl;
+    std::cout << std::setw(10) << "n" << std::setw(12) << "midpoint" << std::setw(12) << "simpson"
+              << std::setw(12) << "gauss3" << std::setw(12) << "gauss5" << std::endl;
+    double time = 0;
+    for(std::int64_t n = 10; n <= 10000000; n *= 10){
+        tbb::tick_count t0 = tbb::tick_count::now();
+        double g5 = Quadrature::integrate<Quadrature::GaussLegendre<5>>(f, F::A, F::B, n);
+        time = (tbb::tick_count::now() - t0).seconds();
+        std::cout << std::setw(10) << n << std::setprecision(2) << std::scientific
+                  << std::setw(12) << std::abs(Quadrature::integrate<Quadrature::Midpoint>(f, F::A, F::B, n) - F::exact())
+                  << std::setw(12) << std::abs(Quadrature::integrate<Quadrature::Simpson>(f, F::A, F::B, n) - F::exact())
+                  << std::setw(12) << std::abs(Quadrature::integrate<Quadrature::GaussLegendre<3>>(f, F::A, F::B, n) - F::exact())
+                  << std::setw(12) << std::abs(g5 - F::exact()) << std::defaultfloat << std::endl;
+    }
+    std::cout << "  gauss5 with 1e7 intervals: " << std::setprecision(3) << time << " s" << std::endl;
+    for(double tol : {1e-6, 1e-10, 1e-13}){
+        tbb::tick_count t0 = tbb::tick_count::now();
+        auto r = Quadrature::adaptive(f, F::A, F::B, tol);
+        double t = (tbb::tick_count::now() - t0).seconds();
+        std::cout << "  adaptive tol " << std::setprecision(0) << std::scientific << tol << ": error "
+                  << std::setprecision(2) << std::abs(r.value - F::exact()) << ", estimate " << r.error
+                  << std::defaultfloat << std::setprecision(3) << ", " << r.panels << " panels, " << t << " s" << std::endl;
+    }
+}
+
+void testQuadrature(){
+    convergence<QuarterCircle>();
+    convergence<Gaussian>();
+    convergence<Runge>();
+    convergence<Oscillatory>();
+    //区间个数超过int的范围
+    const std::int64_t n = (1LL << 31) + 11;
+    tbb::tick_count t0 = tbb::tick_count::now();
+    double pi = Quadrature::integrate<Quadrature::Midpoint>(QuarterCircle(), 0, 1, n);
+    std::cout << "midpoint PI with " << n << " intervals: error " << std::setprecision(3)
+              << std::abs(pi - QuarterCircle::exact()) << ", " << (tbb::tick_count::now() - t0).seconds() << " s" << std::endl;
+}
+
 int main(){
     std::vector<int> a = {1,4,5,8,9,3,4,6,0};
     std::cout << pmax(a) << std::endl;
     std::cout << "PI = " << calcPI(100000) << std::endl;
+    const std::int64_t degree = 100000000;
+    comparePI<FloatReduce::Method::Naive>(degree);
+    comparePI<FloatReduce::Method::Kahan>(degree);
+    comparePI<FloatReduce::Method::Neumaier>(degree);
+    comparePI<FloatReduce::Method::Pairwise>(degree);
+    testArraySum();
+    testMinMax();
+    testFusedStats();
+    testQuadrature();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include <cmath>
+#include <cstdint>
+#include "PixelKernels.h"
+#include "DispatchVariant.h"
+
+//这个文件按不同的ISA编译多次，见DispatchVariant.h
+//像素直接写bgra，不调用Pixel的构造函数（头文件里的inline函数在各ISA之间共用一份）
+namespace PixelKernels {
+    namespace SAMPLES_ISA_NS {
+
+        void gammaRow(const Pixel *in, Pixel *out, int width, double gamma) {
+            for (int j = 0; j < width; ++j) {
+                const std::uint8_t *p = in[j].bgra;
+                double v = 0.3 * p[2] + 0.59 * p[1] + 0.11 * p[0];
+                double res = std::pow(v, gamma);
+                if (res > ImageLib::MAX_BGR_VALUE) {
+                    res = ImageLib::MAX_BGR_VALUE;
+                }
+                const std::uint8_t c = (std::uint8_t) res;
+                out[j].bgra[0] = c, out[j].bgra[1] = c, out[j].bgra[2] = c, out[j].bgra[3] = 0;
+            }
+        }
+
+        void tintRow(const Pixel *in, Pixel *out, int width, const double *tints) {
+            for (int j = 0; j < width; ++j) {
+                const std::uint8_t *p = in[j].bgra;
+                std::uint8_t b = (double) p[0] + (ImageLib::MAX_BGR_VALUE - p[0]) * tints[0];
+                std::uint8_t g = (double) p[0] + (ImageLib::MAX_BGR_VALUE - p[1]) * tints[1];
+                std::uint8_t r = (double) p[0] + (ImageLib::MAX_BGR_VALUE - p[2]) * tints[2];
+                out[j].bgra[0] = (b > ImageLib::MAX_BGR_VALUE) ? ImageLib::MAX_BGR_VALUE : b;
+                out[j].bgra[1] = (g > ImageLib::MAX_BGR_VALUE) ? ImageLib::MAX_BGR_VALUE : g;
+                out[j].bgra[2] = (r > ImageLib::MAX_BGR_VALUE) ? ImageLib::MAX_BGR_VALUE : r;
+                out[j].bgra[3] = 0;
+            }
+        }
+
+        //ImageLib::Fractal::calcOnePixel的循环，常数和它一致
+        void fractalRow(double magn, int x, int width, int height, Pixel *out) {
+            const double cx = -0.7436, cy = 0.1319;
+            const int max_iter = 1000;
+            const double fx0 = (double(x) - double(width) / 2) / magn + cx;
+            for (int j = 0; j < width; ++j) {
+                const double fy0 = (double(j) - double(height) / 2) / magn + cy;
+                double res = 0, u = 0, v = 0;
+                for (int iter = 0; u * u + v * v <= 4 && iter < max_iter; ++iter) {
+                    const double val = u * u - v * v + fx0;
+                    v = 2 * u * v + fy0, u = val;
+                    res += std::exp(-std::sqrt(u * u + v * v));
+                }
+                if (res > 255) {
+                    res = 255;
+                }
+                const std::uint8_t c = (std::uint8_t) res;
+                out[j].bgra[0] = c, out[j].bgra[1] = c, out[j].bgra[2] = c, out[j].bgra[3] = 0;
+            }
+        }
+    }
+
+    SAMPLES_KERNEL(GammaRow, gammaKernel, "gamma", gammaRow);
+    SAMPLES_KERNEL(TintRow, tintKernel, "tint", tintRow);
+    SAMPLES_KERNEL(FractalRow, fractalKernel, "fractal", fractalRow);
+}
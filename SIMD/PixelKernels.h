@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Dispatch.h"
+#include "ImageLib.h"
+
+//一行像素的gamma矫正、tint着色和分形图
+//PixelKernels.cpp在每个ISA下各编译一份（见cmake/IsaVariants.cmake），下面的kernel包含各版本，
+//调用时Dispatch按CPU选最快的版本：scalar总是有，sse42、avx2、avx512只在打开SAMPLES_ISA_VARIANTS时存在
+namespace PixelKernels {
+
+    using Pixel = ImageLib::Image::Pixel;
+
+    using GammaRow = void (*)(const Pixel *in, Pixel *out, int width, double gamma);
+    using TintRow = void (*)(const Pixel *in, Pixel *out, int width, const double *tints);
+    //分形图的第x行（和ImageLib::makeFractalImage的结果相同）
+    using FractalRow = void (*)(double magn, int x, int width, int height, Pixel *out);
+
+    //定义在PixelKernels.cpp的默认编译里（SAMPLES_KERNEL）
+    Dispatch::Kernel<GammaRow> &gammaKernel();
+    Dispatch::Kernel<TintRow> &tintKernel();
+    Dispatch::Kernel<FractalRow> &fractalKernel();
+
+}
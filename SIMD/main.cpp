@@ -1,8 +1,9 @@
+#include <cstring>
 #include <iostream>
 #include <tbb/tbb.h>
 #include "ImageLib.h"
+#include "PixelKernels.h"
 #include <algorithm>
-#include <execution>
 
 using ImagePtr = std::shared_ptr<ImageLib::Image>;
 
@@ -18,14 +19,7 @@ ImagePtr applyGamma(ImagePtr image_ptr, double gamma){
         [&in_rows, &out_rows, width, gamma](int i){
             auto in_row = in_rows[i];
             auto out_row = out_rows[i];
-            std::transform(in_row, in_row + width, out_row, [gamma](const ImageLib::Image::Pixel &p){
-                double v = 0.3 * p.bgra[2] + 0.59 * p.bgra[1] + 0.11 * p.bgra[0];
-                double res = pow(v, gamma);
-                if(res > ImageLib::MAX_BGR_VALUE){
-                    res = ImageLib::MAX_BGR_VALUE;
-                }
-                return ImageLib::Image::Pixel(res, res, res);
-            });
+            PixelKernels::gammaKernel()(in_row, out_row, width, gamma);
 
             /*for(int j = 0; j < width; ++j){
                 const ImageLib::Image::Pixel& p = in_rows[i][j];
@@ -53,16 +47,7 @@ ImagePtr applyTint(ImagePtr image_ptr, const double *tints){
         [&in_rows, &out_rows, width, tints](int i){
             auto in_row = in_rows[i];
             auto out_row = out_rows[i];
-            std::transform(in_row, in_row + width, out_row, [tints](const ImageLib::Image::Pixel &p){
-                std::uint8_t b = (double)p.bgra[0] + (ImageLib::MAX_BGR_VALUE - p.bgra[0]) * tints[0];
-                std::uint8_t g = (double)p.bgra[0] + (ImageLib::MAX_BGR_VALUE - p.bgra[1]) * tints[1];
-                std::uint8_t r = (double)p.bgra[0] + (ImageLib::MAX_BGR_VALUE - p.bgra[2]) * tints[2];
-                return ImageLib::Image::Pixel(
-                        (b > ImageLib::MAX_BGR_VALUE) ? ImageLib::MAX_BGR_VALUE : b,
-                        (g > ImageLib::MAX_BGR_VALUE) ? ImageLib::MAX_BGR_VALUE : g,
-                        (r > ImageLib::MAX_BGR_VALUE) ? ImageLib::MAX_BGR_VALUE : r
-                );
-            });
+            PixelKernels::tintKernel()(in_row, out_row, width, tints);
             /*for(int j = 0; j < width; ++j){
                 const ImageLib::Image::Pixel& p = in_rows[i][j];
                 std::uint8_t b = (double)p.bgra[0] + (ImageLib::MAX_BGR_VALUE - p.bgra[0]) * tints[0];
@@ -79,6 +64,59 @@ ImagePtr applyTint(ImagePtr image_ptr, const double *tints){
     return output_image_ptr;
 }
 
+//和ImageLib::makeFractalImage的结果相同，每行一个任务，用按CPU选的fractal kernel
+ImagePtr makeFractalImage(double magn){
+    auto image_ptr = std::make_shared<ImageLib::Image>(std::string("fractal_") + std::to_string((int)magn),
+                                                       ImageLib::IMAGE_WIDTH, ImageLib::IMAGE_HEIGHT);
+    auto &rows = image_ptr->rows();
+    const int width = image_ptr->width();
+    const int height = image_ptr->height();
+    tbb::parallel_for(0, height, [&rows, magn, width, height](int x){
+        PixelKernels::fractalKernel()(magn, x, width, height, rows[x]);
+    });
+    return image_ptr;
+}
+
+bool sameImage(ImageLib::Image &a, ImageLib::Image &b){
+    for(int i = 0; i < a.height(); ++i){
+        if(std::memcmp(a.rows()[i], b.rows()[i], a.width() * sizeof(ImageLib::Image::Pixel)) != 0){
+            return false;
+        }
+    }
+    return true;
+}
+
+//本机CPU支持的每个ISA版本都和ImageLib、scalar版本的结果逐位比较
+void checkVariants(){
+    const double magn = 20000;
+    const double tints[] = {0.75, 0, 0};
+    auto gold = ImageLib::makeFractalImage(magn);
+    const int width = gold->width();
+    const int height = gold->height();
+    ImageLib::Image gamma_gold("gamma", width, height), tint_gold("tint", width, height), out("out", width, height);
+    for(int x = 0; x < height; ++x){
+        PixelKernels::gammaKernel().variant(Dispatch::Isa::Scalar)(gold->rows()[x], gamma_gold.rows()[x], width, 1.4);
+        PixelKernels::tintKernel().variant(Dispatch::Isa::Scalar)(gold->rows()[x], tint_gold.rows()[x], width, tints);
+    }
+    for(int i = 0; i <= (int)Dispatch::detectIsa(); ++i){
+        const auto isa = (Dispatch::Isa)i;
+        auto fractal = PixelKernels::fractalKernel().variant(isa);
+        auto gamma = PixelKernels::gammaKernel().variant(isa);
+        auto tint = PixelKernels::tintKernel().variant(isa);
+        if(fractal == nullptr || gamma == nullptr || tint == nullptr){
+            continue;
+        }
+        bool ok = true;
+        for(int x = 0; x < height; ++x) fractal(magn, x, width, height, out.rows()[x]);
+        ok = ok && sameImage(out, *gold);
+        for(int x = 0; x < height; ++x) gamma(gold->rows()[x], out.rows()[x], width, 1.4);
+        ok = ok && sameImage(out, gamma_gold);
+        for(int x = 0; x < height; ++x) tint(gold->rows()[x], out.rows()[x], width, tints);
+        ok = ok && sameImage(out, tint_gold);
+        std::cout << "  check " << Dispatch::isaName(isa) << ": " << (ok ? "ok" : "MISMATCH") << std::endl;
+    }
+}
+
 void writeImage(ImagePtr image_ptr){
     image_ptr->write((image_ptr->name() + ".bmp").c_str());
 }
@@ -123,9 +161,12 @@ void fig1_10(const std::vector<ImagePtr>& image_vector){
 }
 
 int main() {
+    //各kernel选中的版本，环境变量SAMPLES_ISA可以强制用较低的版本
+    Dispatch::report(std::cout);
+    checkVariants();
     std::vector<ImagePtr> image_vector;
     for(int i = 2000; i < 2000000; i *= 10){
-        image_vector.push_back(ImageLib::makeFractalImage(i));
+        image_vector.push_back(makeFractalImage(i));
     }
     //空转，让scheduler warmup
     tbb::parallel_for(0, 8, [](int){
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <tbb/tbb.h>
+#include "ParallelScan.h"
+
+//基于扫描的并行流压缩：copy_if、按下标选择、稳定划分
+//压缩的输出位置就是"保留标志"的排除式前缀和
+//copyIf/selectIndices是单趟的：每块把保留标志记在栈上的字节数组里并计数，
+//用Scan::LookBack得到前面各块的保留个数之和，再把保留的元素写到输出，输入只读一次
+namespace Compaction {
+
+    //每块的元素个数，保留标志放在栈上
+    const std::size_t CHUNK_SIZE = 8192;
+
+    //通用的单趟压缩：keep(i)决定是否保留第i个元素，emit(i, pos)把它写到输出的第pos个位置，返回保留的个数
+    template <typename Keep, typename Emit>
+    std::size_t compact(std::size_t n, Keep keep, Emit emit) {
+        const std::size_t num_chunks = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        Scan::LookBack<std::size_t, Scan::Sum<std::size_t>> look_back(num_chunks, Scan::Sum<std::size_t>());
+        look_back.run([&](std::size_t c) {
+            const std::size_t begin = c * CHUNK_SIZE, len = std::min(n, begin + CHUNK_SIZE) - begin;
+            std::uint8_t flags[CHUNK_SIZE];
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < len; ++i) {
+                flags[i] = keep(begin + i) ? 1 : 0;
+                count += flags[i];
+            }
+            std::size_t pos = look_back.exclusivePrefix(c, count);
+            for (std::size_t i = 0; i < len; ++i) {
+                if (flags[i]) {
+                    emit(begin + i, pos++);
+                }
+            }
+        });
+        return look_back.total();
+    }
+
+    //保留pred(in[i])为真的元素，保持原来的顺序；out至少要有n个元素的空间，返回保留的个数
+    template <typename T, typename Pred>
+    std::size_t copyIf(const T *in, T *out, std::size_t n, Pred pred) {
+        return compact(n, [&](std::size_t i) { return pred(in[i]); },
+                       [&](std::size_t i, std::size_t pos) { out[pos] = in[i]; });
+    }
+
+    //满足pred(i)的下标（选择向量），列式数据上用同一个选择向量gather多列
+    template <typename Index, typename Pred>
+    std::size_t selectIndices(std::size_t n, Index *out, Pred pred) {
+        return compact(n, pred, [&](std::size_t i, std::size_t pos) { out[pos] = (Index) i; });
+    }
+
+    //按选择向量并行gather一列
+    template <typename T, typename Index>
+    void gather(const T *in, const Index *indices, std::size_t count, T *out) {
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, count), [&](const tbb::blocked_range<std::size_t> &r) {
+            for (std::size_t k = r.begin(); k != r.end(); ++k) {
+                out[k] = in[indices[k]];
+            }
+        });
+    }
+
+    //稳定划分：pred为真的元素按原顺序放在out的前面，为假的按原顺序放在后面，返回为真的个数
+    //为假的元素的位置依赖为真的总数，所以不能单趟：第一趟并行计算保留标志（字节，不用vector<bool>）和每块的计数，
+    //串行扫描块计数得到偏移，第二趟并行按标志写出，pred只求值一次
+    template <typename T, typename Pred>
+    std::size_t partitionCopy(const T *in, T *out, std::size_t n, Pred pred) {
+        const std::size_t num_chunks = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        std::vector<std::uint8_t> flags(n);
+        std::vector<std::size_t> true_before(num_chunks + 1, 0);
+        tbb::parallel_for(std::size_t(0), num_chunks, [&](std::size_t c) {
+            const std::size_t begin = c * CHUNK_SIZE, end = std::min(n, begin + CHUNK_SIZE);
+            std::size_t count = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                flags[i] = pred(in[i]) ? 1 : 0;
+                count += flags[i];
+            }
+            true_before[c + 1] = count;
+        });
+        Scan::serialScan(true_before.data(), true_before.data(), num_chunks + 1);
+        const std::size_t num_true = true_before[num_chunks];
+        tbb::parallel_for(std::size_t(0), num_chunks, [&](std::size_t c) {
+            const std::size_t begin = c * CHUNK_SIZE, end = std::min(n, begin + CHUNK_SIZE);
+            std::size_t t = true_before[c];
+            //块c之前为假的个数 = 块c之前的元素个数 - 为真的个数
+            std::size_t f = num_true + begin - true_before[c];
+            for (std::size_t i = begin; i < end; ++i) {
+                if (flags[i]) {
+                    out[t++] = in[i];
+                } else {
+                    out[f++] = in[i];
+                }
+            }
+        });
+        return num_true;
+    }
+
+}
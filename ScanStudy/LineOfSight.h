@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <tbb/tbb.h>
+
+//视线（line of sight）计算
+//- 比较的是坡度 rise / run（run > 0），它和atan2(run, -rise)单调对应，交叉相乘比较，不用atan2也不用除法
+//- 输出是按64位字对齐的位图：并行时每个任务只写整字，相邻任务不会写同一个字（std::vector<bool>做不到）
+//- 剖面：一个很长的一维高度剖面，观察点在下标0，parallel_scan求最大坡度
+//- 径向线：二维高程图上多个观察点、每个观察点多条径向线，各条线之间并行
+namespace LineOfSight {
+
+    const std::size_t WORD_BITS = 64;
+    const double PI = 3.14159265358979323846;
+
+    //从观察点看一个点的坡度：rise是相对观察点的高差，run是水平距离
+    struct Slope {
+        double rise;
+        double run;
+    };
+
+    //a不低于b（a的仰角 >= b的仰角）
+    inline bool notBelow(const Slope &a, const Slope &b) {
+        return a.rise * b.run >= b.rise * a.run;
+    }
+
+    inline Slope steeper(const Slope &a, const Slope &b) {
+        return notBelow(a, b) ? a : b;
+    }
+
+    //比任何点都低的坡度，作为最大值扫描的初值
+    const Slope LOWEST_SLOPE = {-1.0, 0.0};
+
+    //按64位字存储的位图，字对齐的并行写入互不干扰
+    class VisibilityBits {
+    public:
+        explicit VisibilityBits(std::size_t n = 0) : mySize(n), myWords((n + WORD_BITS - 1) / WORD_BITS, 0) {}
+
+        std::size_t size() const { return mySize; }
+        std::size_t numWords() const { return myWords.size(); }
+        bool test(std::size_t i) const { return (myWords[i / WORD_BITS] >> (i % WORD_BITS)) & 1; }
+        std::uint64_t *words() { return myWords.data(); }
+        const std::uint64_t *words() const { return myWords.data(); }
+
+        std::size_t count() const {
+            std::size_t c = 0;
+            for (std::uint64_t w : myWords) {
+                while (w) {
+                    w &= w - 1;
+                    ++c;
+                }
+            }
+            return c;
+        }
+
+    private:
+        std::size_t mySize;
+        std::vector<std::uint64_t> myWords;
+    };
+
+    //一维剖面的可见性：heights[0]处的观察者（眼睛高出地面observer_height），点间距dx
+    //点i可见，当且仅当它的坡度不低于1..i-1中的最大坡度
+    //parallel_scan的范围是字下标，每个块处理整字对应的点，只写自己的字
+    inline void profileVisibility(const double *heights, std::size_t n, double dx, VisibilityBits &visible,
+                                  double observer_height = 0.0) {
+        visible = VisibilityBits(n);
+        if (n == 0) {
+            return;
+        }
+        const double eye = heights[0] + observer_height;
+        std::uint64_t *words = visible.words();
+        //观察点本身可见
+        words[0] = 1;
+        tbb::parallel_scan(
+                tbb::blocked_range<std::size_t>(0, visible.numWords()),
+                LOWEST_SLOPE,
+                [=](const tbb::blocked_range<std::size_t> &r, Slope max_slope, bool is_final_scan) -> Slope {
+                    for (std::size_t w = r.begin(); w != r.end(); ++w) {
+                        const std::size_t i0 = std::max<std::size_t>(w * WORD_BITS, 1);
+                        const std::size_t i1 = std::min(n, (w + 1) * WORD_BITS);
+                        std::uint64_t bits = (w == 0) ? 1 : 0;
+                        for (std::size_t i = i0; i < i1; ++i) {
+                            const Slope s{heights[i] - eye, i * dx};
+                            if (notBelow(s, max_slope)) {
+                                max_slope = s;
+                                bits |= std::uint64_t(1) << (i % WORD_BITS);
+                            }
+                        }
+                        if (is_final_scan) {
+                            words[w] = bits;
+                        }
+                    }
+                    return max_slope;
+                },
+                [](const Slope &a, const Slope &b) { return steeper(a, b); });
+    }
+
+    //二维高程图，行主序，cell_size是格点间距（与高度同一单位）
+    struct Heightmap {
+        int width = 0;
+        int height = 0;
+        double cell_size = 1.0;
+        std::vector<float> z;
+
+        Heightmap() = default;
+        Heightmap(int w, int h, double cell = 1.0) : width(w), height(h), cell_size(cell), z((std::size_t) w * h) {}
+
+        float at(int x, int y) const { return z[(std::size_t) y * width + x]; }
+        float &at(int x, int y) { return z[(std::size_t) y * width + x]; }
+        bool contains(double x, double y) const { return x >= 0 && y >= 0 && x <= width - 1 && y <= height - 1; }
+
+        //双线性插值，(x, y)以格点为单位，要求contains(x, y)
+        double sample(double x, double y) const {
+            const int x0 = std::min((int) x, width - 2), y0 = std::min((int) y, height - 2);
+            const double fx = x - x0, fy = y - y0;
+            const double top = at(x0, y0) * (1 - fx) + at(x0 + 1, y0) * fx;
+            const double bottom = at(x0, y0 + 1) * (1 - fx) + at(x0 + 1, y0 + 1) * fx;
+            return top * (1 - fy) + bottom * fy;
+        }
+    };
+
+    //观察点：格点坐标和眼睛离地高度
+    struct Observer {
+        double x;
+        double y;
+        double eye_height;
+    };
+
+    //多观察点的径向线结果：观察点o的第r条线（方向角2*pi*r/num_rays）上第k个采样点（离观察点(k+1)*step格）是否可见
+    //每条线的位图从字边界开始，一条线只由一个任务写
+    class RadialViewshed {
+    public:
+        RadialViewshed(int num_observers, int num_rays, int max_samples)
+                : myNumRays(num_rays), myMaxSamples(max_samples),
+                  myWordsPerRay((max_samples + WORD_BITS - 1) / WORD_BITS),
+                  myWords((std::size_t) num_observers * num_rays * myWordsPerRay, 0),
+                  mySamples((std::size_t) num_observers * num_rays, 0) {}
+
+        int numRays() const { return myNumRays; }
+        int maxSamples() const { return myMaxSamples; }
+        //射线离开高程图之前的采样点个数
+        int samples(int o, int r) const { return mySamples[(std::size_t) o * myNumRays + r]; }
+        bool visible(int o, int r, int k) const {
+            return (rayWords(o, r)[k / WORD_BITS] >> (k % WORD_BITS)) & 1;
+        }
+
+        std::uint64_t *rayWords(int o, int r) {
+            return &myWords[((std::size_t) o * myNumRays + r) * myWordsPerRay];
+        }
+        const std::uint64_t *rayWords(int o, int r) const {
+            return &myWords[((std::size_t) o * myNumRays + r) * myWordsPerRay];
+        }
+        void setSamples(int o, int r, int k) { mySamples[(std::size_t) o * myNumRays + r] = k; }
+
+    private:
+        int myNumRays;
+        int myMaxSamples;
+        std::size_t myWordsPerRay;
+        std::vector<std::uint64_t> myWords;
+        std::vector<int> mySamples;
+    };
+
+    //沿一条射线的最大坡度扫描，射线很短（最多几千个采样点），串行；
+    //写入rayWords，返回离开高程图之前的采样点个数
+    inline int scanRay(const Heightmap &map, const Observer &obs, double dir_x, double dir_y, double step,
+                       int max_samples, std::uint64_t *ray_words) {
+        const double eye = map.sample(obs.x, obs.y) + obs.eye_height;
+        Slope max_slope = LOWEST_SLOPE;
+        std::uint64_t bits = 0;
+        int k = 0;
+        for (; k < max_samples; ++k) {
+            const double d = (k + 1) * step;
+            const double x = obs.x + dir_x * d, y = obs.y + dir_y * d;
+            if (!map.contains(x, y)) {
+                break;
+            }
+            const Slope s{map.sample(x, y) - eye, d * map.cell_size};
+            if (notBelow(s, max_slope)) {
+                max_slope = s;
+                bits |= std::uint64_t(1) << (k % WORD_BITS);
+            }
+            if (k % WORD_BITS == WORD_BITS - 1) {
+                ray_words[k / WORD_BITS] = bits;
+                bits = 0;
+            }
+        }
+        if (k % WORD_BITS != 0) {
+            ray_words[k / WORD_BITS] = bits;
+        }
+        return k;
+    }
+
+    //所有观察点 x 所有径向线并行；step是采样间距（格），max_range是最远距离（格）
+    inline RadialViewshed radialLines(const Heightmap &map, const std::vector<Observer> &observers, int num_rays,
+                                      double step = 1.0, double max_range = 1e300) {
+        const double diagonal = std::hypot(map.width, map.height);
+        const int max_samples = (int) (std::min(max_range, diagonal) / step);
+        RadialViewshed result((int) observers.size(), num_rays, max_samples);
+        tbb::parallel_for(tbb::blocked_range2d<int>(0, (int) observers.size(), 1, 0, num_rays, 16),
+                          [&](const tbb::blocked_range2d<int> &r) {
+                              for (int o = r.rows().begin(); o != r.rows().end(); ++o) {
+                                  if (!map.contains(observers[o].x, observers[o].y)) {
+                                      continue;
+                                  }
+                                  for (int ray = r.cols().begin(); ray != r.cols().end(); ++ray) {
+                                      const double theta = 2 * PI * ray / num_rays;
+                                      int k = scanRay(map, observers[o], std::cos(theta), std::sin(theta), step,
+                                                      max_samples, result.rayWords(o, ray));
+                                      result.setSamples(o, ray, k);
+                                  }
+                              }
+                          });
+        return result;
+    }
+
+}
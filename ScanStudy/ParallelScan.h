@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <tbb/tbb.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SCAN_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SCAN_NEON 1
+#endif
+
+//通用的并行前缀扫描
+//- 任意类型T和满足结合律的运算Op（Op::identity()是单位元），in == out时就地扫描
+//- parallelScan：两趟（先各块归约，再各块带偏移扫描），与tbb::parallel_scan相同的思路，但块内扫描用SIMD
+//- singlePassScan：单趟decoupled look-back，输入只读一次
+//- 块内求和用SIMD的log-step前缀（寄存器内移位相加），目前支持int32、float、double的求和
+namespace Scan {
+
+    //每块的字节数，块内扫描和修正时数据留在L2里
+    const std::size_t CHUNK_BYTES = 64 << 10;
+    //少于该元素个数时串行
+    const std::size_t SERIAL_THRESHOLD = 1 << 15;
+
+    template <typename T>
+    struct Sum {
+        static T identity() { return T(0); }
+        T operator()(const T &a, const T &b) const { return a + b; }
+    };
+
+    template <typename T>
+    struct Max {
+        static T identity() { return std::numeric_limits<T>::lowest(); }
+        T operator()(const T &a, const T &b) const { return std::max(a, b); }
+    };
+
+    template <typename T>
+    struct Min {
+        static T identity() { return std::numeric_limits<T>::max(); }
+        T operator()(const T &a, const T &b) const { return std::min(a, b); }
+    };
+
+    template <typename T>
+    std::size_t chunkSize() {
+        return std::max<std::size_t>(CHUNK_BYTES / sizeof(T), 64);
+    }
+
+    //块内扫描的标量版本：out[i] = init op in[0] op ... op in[i]（包含式）
+    //或 init op in[0] op ... op in[i-1]（排除式），先读后写，in == out也正确；返回init op 全部元素
+    template <bool Exclusive, typename T, typename Op>
+    T scalarChunkScan(const T *in, T *out, std::size_t n, T init, Op op) {
+        T acc = init;
+        for (std::size_t i = 0; i < n; ++i) {
+            const T v = in[i];
+            if (Exclusive) {
+                out[i] = acc;
+                acc = op(acc, v);
+            } else {
+                acc = op(acc, v);
+                out[i] = acc;
+            }
+        }
+        return acc;
+    }
+
+    //SIMD log-step：寄存器内 x += x << 1个元素，x += x << 2个元素，再加上前一个寄存器的最后一个元素
+    //浮点的加法顺序与串行不同，结果会有舍入级别的差别
+#if defined(SCAN_SSE2)
+    inline std::int32_t simdSumScan(const std::int32_t *in, std::int32_t *out, std::size_t n, std::int32_t init) {
+        __m128i carry = _mm_set1_epi32(init);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i x = _mm_loadu_si128((const __m128i *) (in + i));
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi32(x, carry);
+            _mm_storeu_si128((__m128i *) (out + i), x);
+            carry = _mm_shuffle_epi32(x, 0xFF);
+        }
+        return scalarChunkScan<false>(in + i, out + i, n - i, _mm_cvtsi128_si32(carry), Sum<std::int32_t>());
+    }
+
+    inline float simdSumScan(const float *in, float *out, std::size_t n, float init) {
+        __m128 carry = _mm_set1_ps(init);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 x = _mm_loadu_ps(in + i);
+            x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+            x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+            x = _mm_add_ps(x, carry);
+            _mm_storeu_ps(out + i, x);
+            carry = _mm_shuffle_ps(x, x, 0xFF);
+        }
+        return scalarChunkScan<false>(in + i, out + i, n - i, _mm_cvtss_f32(carry), Sum<float>());
+    }
+
+    inline double simdSumScan(const double *in, double *out, std::size_t n, double init) {
+        __m128d carry = _mm_set1_pd(init);
+        std::size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d x = _mm_loadu_pd(in + i);
+            x = _mm_add_pd(x, _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(x), 8)));
+            x = _mm_add_pd(x, carry);
+            _mm_storeu_pd(out + i, x);
+            carry = _mm_unpackhi_pd(x, x);
+        }
+        return scalarChunkScan<false>(in + i, out + i, n - i, _mm_cvtsd_f64(carry), Sum<double>());
+    }
+#elif defined(SCAN_NEON)
+    inline std::int32_t simdSumScan(const std::int32_t *in, std::int32_t *out, std::size_t n, std::int32_t init) {
+        const int32x4_t zero = vdupq_n_s32(0);
+        int32x4_t carry = vdupq_n_s32(init);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            int32x4_t x = vld1q_s32(in + i);
+            x = vaddq_s32(x, vextq_s32(zero, x, 3));
+            x = vaddq_s32(x, vextq_s32(zero, x, 2));
+            x = vaddq_s32(x, carry);
+            vst1q_s32(out + i, x);
+            carry = vdupq_laneq_s32(x, 3);
+        }
+        return scalarChunkScan<false>(in + i, out + i, n - i, vgetq_lane_s32(carry, 0), Sum<std::int32_t>());
+    }
+
+    inline float simdSumScan(const float *in, float *out, std::size_t n, float init) {
+        const float32x4_t zero = vdupq_n_f32(0);
+        float32x4_t carry = vdupq_n_f32(init);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            float32x4_t x = vld1q_f32(in + i);
+            x = vaddq_f32(x, vextq_f32(zero, x, 3));
+            x = vaddq_f32(x, vextq_f32(zero, x, 2));
+            x = vaddq_f32(x, carry);
+            vst1q_f32(out + i, x);
+            carry = vdupq_laneq_f32(x, 3);
+        }
+        return scalarChunkScan<false>(in + i, out + i, n - i, vgetq_lane_f32(carry, 0), Sum<float>());
+    }
+
+    inline double simdSumScan(const double *in, double *out, std::size_t n, double init) {
+        const float64x2_t zero = vdupq_n_f64(0);
+        float64x2_t carry = vdupq_n_f64(init);
+        std::size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            float64x2_t x = vld1q_f64(in + i);
+            x = vaddq_f64(x, vextq_f64(zero, x, 1));
+            x = vaddq_f64(x, carry);
+            vst1q_f64(out + i, x);
+            carry = vdupq_laneq_f64(x, 1);
+        }
+        return scalarChunkScan<false>(in + i, out + i, n - i, vgetq_lane_f64(carry, 0), Sum<double>());
+    }
+#endif
+
+    //有SIMD版本的(T, Op)组合
+    template <typename T, typename Op>
+    constexpr bool hasSimdScan() {
+#if defined(SCAN_SSE2) || defined(SCAN_NEON)
+        return std::is_same<Op, Sum<T>>::value &&
+               (std::is_same<T, std::int32_t>::value || std::is_same<T, float>::value ||
+                std::is_same<T, double>::value);
+#else
+        return false;
+#endif
+    }
+
+    //块内扫描：包含式求和走SIMD，其余走标量
+    template <bool Exclusive, typename T, typename Op>
+    T chunkScan(const T *in, T *out, std::size_t n, T init, Op op) {
+        if constexpr (!Exclusive && hasSimdScan<T, Op>()) {
+            return simdSumScan(in, out, n, init);
+        } else {
+            return scalarChunkScan<Exclusive>(in, out, n, init, op);
+        }
+    }
+
+    //块内归约
+    template <typename T, typename Op>
+    T chunkReduce(const T *in, std::size_t n, Op op) {
+        T acc = Op::identity();
+        for (std::size_t i = 0; i < n; ++i) {
+            acc = op(acc, in[i]);
+        }
+        return acc;
+    }
+
+    //块内所有元素左乘前缀：out[i] = prefix op out[i]，look-back得到前缀后的修正
+    template <typename T, typename Op>
+    void applyPrefix(T *out, std::size_t n, T prefix, Op op) {
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = op(prefix, out[i]);
+        }
+    }
+
+    //串行扫描，返回全部元素的归约
+    template <bool Exclusive = false, typename T, typename Op = Sum<T>>
+    T serialScan(const T *in, T *out, std::size_t n, Op op = Op()) {
+        return chunkScan<Exclusive>(in, out, n, Op::identity(), op);
+    }
+
+    //两趟扫描：第一趟并行求各块的归约，串行扫描块的归约得到各块的前缀，第二趟各块并行带前缀扫描
+    //输入读两次，in == out时就地扫描
+    template <bool Exclusive = false, typename T, typename Op = Sum<T>>
+    T parallelScan(const T *in, T *out, std::size_t n, Op op = Op()) {
+        if (n < SERIAL_THRESHOLD) {
+            return serialScan<Exclusive>(in, out, n, op);
+        }
+        const std::size_t chunk = chunkSize<T>();
+        const std::size_t num_chunks = (n + chunk - 1) / chunk;
+        std::vector<T> prefix(num_chunks + 1);
+        tbb::parallel_for(std::size_t(0), num_chunks, [&](std::size_t c) {
+            const std::size_t begin = c * chunk, end = std::min(n, begin + chunk);
+            prefix[c + 1] = chunkReduce(in + begin, end - begin, op);
+        });
+        prefix[0] = Op::identity();
+        for (std::size_t c = 0; c < num_chunks; ++c) {
+            prefix[c + 1] = op(prefix[c], prefix[c + 1]);
+        }
+        tbb::parallel_for(std::size_t(0), num_chunks, [&](std::size_t c) {
+            const std::size_t begin = c * chunk, end = std::min(n, begin + chunk);
+            chunkScan<Exclusive>(in + begin, out + begin, end - begin, prefix[c], op);
+        });
+        return prefix[num_chunks];
+    }
+
+    //look-back中每块的状态，补齐到cache line，避免相邻块伪共享
+    template <typename T>
+    struct alignas(64) ChunkStatus {
+        //0：还没有结果；1：aggregate有效（本块归约）；2：inclusive有效（前面所有块加本块）
+        std::atomic<int> flag{0};
+        T aggregate;
+        T inclusive;
+    };
+
+    //decoupled look-back：单趟算法（扫描、压缩）共用的块间前缀传递
+    //块的编号按开始执行的先后用原子计数器发放（而不是按任务编号），等待的前驱块一定已经在某个线程上执行，
+    //不会出现等待一个还没被调度的块而死锁
+    template <typename T, typename Op>
+    class LookBack {
+    public:
+        static_assert(std::is_trivially_copyable<T>::value, "look-back publishes values across threads");
+
+        LookBack(std::size_t num_chunks, Op op) : myStatus(num_chunks), myOp(op) {}
+
+        //body(c)对每个块调用一次，c按开始执行的先后递增
+        template <typename Body>
+        void run(Body body) {
+            tbb::parallel_for(tbb::blocked_range<std::size_t>(0, myStatus.size(), 1),
+                              [&](const tbb::blocked_range<std::size_t> &r) {
+                                  for (std::size_t k = r.begin(); k != r.end(); ++k) {
+                                      body(myNextTicket.fetch_add(1, std::memory_order_relaxed));
+                                  }
+                              });
+        }
+
+        //发布块c的归约，向前看累加前驱的aggregate，直到遇到发布了inclusive的块，返回块c之前所有块的归约
+        T exclusivePrefix(std::size_t c, const T &aggregate) {
+            ChunkStatus<T> &self = myStatus[c];
+            if (c == 0) {
+                self.inclusive = aggregate;
+                self.flag.store(2, std::memory_order_release);
+                return Op::identity();
+            }
+            self.aggregate = aggregate;
+            self.flag.store(1, std::memory_order_release);
+
+            T exclusive = Op::identity();
+            for (std::size_t p = c - 1;; --p) {
+                int flag;
+                int spins = 0;
+                while ((flag = myStatus[p].flag.load(std::memory_order_acquire)) == 0) {
+                    if (++spins > 64) {
+                        std::this_thread::yield();
+                    }
+                }
+                if (flag == 2) {
+                    exclusive = myOp(myStatus[p].inclusive, exclusive);
+                    break;
+                }
+                exclusive = myOp(myStatus[p].aggregate, exclusive);
+            }
+            self.inclusive = myOp(exclusive, aggregate);
+            self.flag.store(2, std::memory_order_release);
+            return exclusive;
+        }
+
+        //run结束后，全部块的归约
+        T total() const { return myStatus.empty() ? Op::identity() : myStatus.back().inclusive; }
+
+    private:
+        std::vector<ChunkStatus<T>, tbb::cache_aligned_allocator<ChunkStatus<T>>> myStatus;
+        std::atomic<std::size_t> myNextTicket{0};
+        Op myOp;
+    };
+
+    //单趟decoupled look-back扫描
+    //每块：扫描本块（identity为初值）并发布aggregate → 向前看得到前缀 → 用前缀修正本块（数据仍在cache里）
+    template <bool Exclusive = false, typename T, typename Op = Sum<T>>
+    T singlePassScan(const T *in, T *out, std::size_t n, Op op = Op()) {
+        if (n < SERIAL_THRESHOLD) {
+            return serialScan<Exclusive>(in, out, n, op);
+        }
+        const std::size_t chunk = chunkSize<T>();
+        LookBack<T, Op> look_back((n + chunk - 1) / chunk, op);
+        look_back.run([&](std::size_t c) {
+            const std::size_t begin = c * chunk, len = std::min(n, begin + chunk) - begin;
+            //排除式的块内扫描本身不产生最后一个元素的归约，由返回值给出
+            const T aggregate = chunkScan<Exclusive>(in + begin, out + begin, len, Op::identity(), op);
+            const T exclusive = look_back.exclusivePrefix(c, aggregate);
+            if (c > 0) {
+                applyPrefix(out + begin, len, exclusive, op);
+            }
+        });
+        return look_back.total();
+    }
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <tbb/tbb.h>
+#include "ParallelScan.h"
+
+//分段扫描：每段独立做前缀扫描，段的划分用头标志（flags[i] != 0表示第i个元素是段首）
+//或者段首偏移数组（CSR的row_ptr形式，offsets[k]是第k段的第一个元素）给出
+//与ParallelScan.h的parallelScan一样是两趟：第一趟各块求(是否有段首, 最后一个段首之后的归约)，
+//串行合并出各块的进位，第二趟各块带进位扫描
+namespace Scan {
+
+    //头标志：每个元素一个字节
+    struct FlagHeads {
+        const std::uint8_t *flags;
+
+        struct Cursor {
+            const std::uint8_t *flags;
+            bool isHead(std::size_t i) { return flags[i] != 0; }
+        };
+        Cursor at(std::size_t) const { return Cursor{flags}; }
+    };
+
+    //段首偏移：offsets[0, num_segments)递增，允许空段（相邻偏移相等）
+    struct OffsetHeads {
+        const std::size_t *offsets;
+        std::size_t num_segments;
+
+        //从第i个元素开始顺序查询，只在块开始时二分查找一次
+        struct Cursor {
+            const std::size_t *offsets;
+            std::size_t num_segments;
+            std::size_t k;
+            bool isHead(std::size_t i) {
+                bool head = false;
+                while (k < num_segments && offsets[k] == i) {
+                    head = true;
+                    ++k;
+                }
+                return head;
+            }
+        };
+        Cursor at(std::size_t begin) const {
+            std::size_t k = std::lower_bound(offsets, offsets + num_segments, begin) - offsets;
+            return Cursor{offsets, num_segments, k};
+        }
+    };
+
+    //一块的分段归约：块内有没有段首，以及最后一个段首（没有段首则从块首）到块尾的归约
+    template <typename T>
+    struct SegmentCarry {
+        bool has_head;
+        T tail;
+    };
+
+    //块内分段扫描，carry是块首所在段在块之前部分的归约
+    template <bool Exclusive, typename T, typename Op, typename Heads>
+    void segmentedChunkScan(const T *in, T *out, std::size_t begin, std::size_t end, T carry, Heads heads, Op op) {
+        auto cursor = heads.at(begin);
+        T acc = carry;
+        for (std::size_t i = begin; i < end; ++i) {
+            const T v = in[i];
+            if (cursor.isHead(i)) {
+                acc = Op::identity();
+            }
+            if (Exclusive) {
+                out[i] = acc;
+                acc = op(acc, v);
+            } else {
+                acc = op(acc, v);
+                out[i] = acc;
+            }
+        }
+    }
+
+    template <bool Exclusive, typename T, typename Op, typename Heads>
+    void segmentedScanImpl(const T *in, T *out, std::size_t n, Heads heads, Op op) {
+        const std::size_t chunk = chunkSize<T>();
+        const std::size_t num_chunks = (n + chunk - 1) / chunk;
+        if (n < SERIAL_THRESHOLD) {
+            segmentedChunkScan<Exclusive>(in, out, 0, n, Op::identity(), heads, op);
+            return;
+        }
+        std::vector<SegmentCarry<T>> carries(num_chunks);
+        tbb::parallel_for(std::size_t(0), num_chunks, [&](std::size_t c) {
+            const std::size_t begin = c * chunk, end = std::min(n, begin + chunk);
+            auto cursor = heads.at(begin);
+            SegmentCarry<T> sc{false, Op::identity()};
+            for (std::size_t i = begin; i < end; ++i) {
+                if (cursor.isHead(i)) {
+                    sc.has_head = true;
+                    sc.tail = Op::identity();
+                }
+                sc.tail = op(sc.tail, in[i]);
+            }
+            carries[c] = sc;
+        });
+        //carries[c]改为块c之前的进位：上一块有段首则从它的tail重新开始，否则接着累加
+        T carry = Op::identity();
+        for (std::size_t c = 0; c < num_chunks; ++c) {
+            const SegmentCarry<T> sc = carries[c];
+            carries[c].tail = carry;
+            carry = sc.has_head ? sc.tail : op(carry, sc.tail);
+        }
+        tbb::parallel_for(std::size_t(0), num_chunks, [&](std::size_t c) {
+            const std::size_t begin = c * chunk, end = std::min(n, begin + chunk);
+            segmentedChunkScan<Exclusive>(in, out, begin, end, carries[c].tail, heads, op);
+        });
+    }
+
+    //按头标志分段扫描，第0个元素总是段首；in == out时就地扫描
+    template <bool Exclusive = false, typename T, typename Op = Sum<T>>
+    void segmentedScan(const T *in, T *out, std::size_t n, const std::uint8_t *flags, Op op = Op()) {
+        segmentedScanImpl<Exclusive>(in, out, n, FlagHeads{flags}, op);
+    }
+
+    //按段首偏移分段扫描
+    template <bool Exclusive = false, typename T, typename Op = Sum<T>>
+    void segmentedScan(const T *in, T *out, std::size_t n, const std::size_t *offsets, std::size_t num_segments,
+                       Op op = Op()) {
+        segmentedScanImpl<Exclusive>(in, out, n, OffsetHeads{offsets, num_segments}, op);
+    }
+
+}
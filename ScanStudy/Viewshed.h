@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <tbb/tbb.h>
+#include "ImageLib.h"
+#include "LineOfSight.h"
+
+//二维视域（viewshed）：高程图上一个观察点能看到哪些格子
+//从观察点向边界上的每个格子发一条射线，沿射线做最大坡度扫描（LineOfSight的坡度比较），各射线并行
+//射线按主轴分成四组（+x、-x、+y、-y），每步沿主轴走一格，副轴坐标是小数，
+//地平线用该列（行）相邻两格的线性插值更新，格子本身用格心高度判断可见
+//每个格子只属于一条射线（副轴坐标最接近的那条），只有它写这个格子，结果没有竞争
+namespace Viewshed {
+
+    using LineOfSight::Heightmap;
+    using LineOfSight::Slope;
+
+    //一组射线内相邻射线一起处理，访问的格子在内存中相邻（+x/-x组沿行走，+y/-y组相邻射线在同一行）
+    const int RAY_GRAIN = 32;
+
+    struct Result {
+        int width = 0;
+        int height = 0;
+        std::vector<std::uint8_t> visible;   //每格一个字节，1表示可见
+
+        bool at(int x, int y) const { return visible[(std::size_t) y * width + x] != 0; }
+        std::size_t count() const { return std::count(visible.begin(), visible.end(), 1); }
+    };
+
+    //主轴为x的一组射线（dir = +1或-1）：观察点在(ox, oy)，到边界的步数D
+    //第t条射线（t在[-D, D]）从观察点走到(ox + dir * D, oy + t)；第s步时副轴坐标oy + t * s / D
+    //格子(ox + dir * s, oy + dy)（|dy| <= s）的所属射线是round(dy * D / s)
+    //swap为true时x、y对调，即主轴为y的一组
+    class Octants {
+    public:
+        Octants(const Heightmap &map, int ox, int oy, double eye, int dir, bool swap, Result &result)
+                : myMap(map), myOx(ox), myOy(oy), myEye(eye), myDir(dir), mySwap(swap), myResult(result) {
+            const int major = swap ? oy : ox, extent = swap ? map.height : map.width;
+            myD = dir > 0 ? extent - 1 - major : major;
+        }
+
+        int numRays() const { return myD > 0 ? 2 * myD + 1 : 0; }
+
+        //第index条射线（t = index - D）
+        void castRay(int index) const {
+            const int t = index - myD;
+            Slope max_slope = LineOfSight::LOWEST_SLOPE;
+            for (int s = 1; s <= myD; ++s) {
+                const double minor = (double) t * s / myD;
+                const int m0 = (int) std::floor(minor);
+                //副轴出界后这条射线结束
+                if (!inside(s, m0) && !inside(s, m0 + 1)) {
+                    break;
+                }
+                //副轴坐标相邻的两个格子里属于本射线的，用格心高度判断
+                for (int m = m0; m <= m0 + 1; ++m) {
+                    if (inside(s, m) && owns(s, m, t)) {
+                        const Slope cell{height(s, m) - myEye, std::hypot((double) s, (double) m) * myMap.cell_size};
+                        myResult.visible[index1D(s, m)] = LineOfSight::notBelow(cell, max_slope);
+                    }
+                }
+                //地平线：射线经过点的插值高度
+                const double f = minor - m0;
+                const double h = inside(s, m0 + 1) && inside(s, m0)
+                                 ? height(s, m0) * (1 - f) + height(s, m0 + 1) * f
+                                 : height(s, inside(s, m0) ? m0 : m0 + 1);
+                max_slope = LineOfSight::steeper(max_slope, Slope{h - myEye, std::hypot((double) s, minor) * myMap.cell_size});
+            }
+        }
+
+    private:
+        //第s步、副轴偏移m的格子坐标
+        int cellX(int s, int m) const { return mySwap ? myOx + m : myOx + myDir * s; }
+        int cellY(int s, int m) const { return mySwap ? myOy + myDir * s : myOy + m; }
+
+        bool inside(int s, int m) const {
+            const int x = cellX(s, m), y = cellY(s, m);
+            return x >= 0 && y >= 0 && x < myMap.width && y < myMap.height;
+        }
+        double height(int s, int m) const { return myMap.at(cellX(s, m), cellY(s, m)); }
+        std::size_t index1D(int s, int m) const { return (std::size_t) cellY(s, m) * myMap.width + cellX(s, m); }
+
+        //格子属于哪一组：主轴为x的组拥有|dy| <= |dx|的格子（包括对角线），主轴为y的组拥有|dx| < |dy|的格子
+        //组内属于副轴坐标最接近的射线：t = round(m * D / s)，整数运算，四舍五入方向固定
+        bool owns(int s, int m, int t) const {
+            if (mySwap ? std::abs(m) >= s : std::abs(m) > s) {
+                return false;
+            }
+            const long long num = 2LL * m * myD + s;
+            const long long den = 2LL * s;
+            long long owner = num / den;
+            if (num % den != 0 && num < 0) {
+                --owner;
+            }
+            return owner == t;
+        }
+
+        const Heightmap &myMap;
+        int myOx, myOy;
+        double myEye;
+        int myDir;
+        bool mySwap;
+        int myD;
+        Result &myResult;
+    };
+
+    //观察点在格子(ox, oy)，眼睛离地eye_height；各组射线并行，每个任务处理RAY_GRAIN条相邻射线
+    inline Result compute(const Heightmap &map, int ox, int oy, double eye_height) {
+        Result result;
+        result.width = map.width;
+        result.height = map.height;
+        result.visible.assign((std::size_t) map.width * map.height, 0);
+        if (ox < 0 || oy < 0 || ox >= map.width || oy >= map.height) {
+            return result;
+        }
+        const double eye = map.at(ox, oy) + eye_height;
+        result.visible[(std::size_t) oy * map.width + ox] = 1;
+        const Octants groups[4] = {
+                Octants(map, ox, oy, eye, +1, false, result),
+                Octants(map, ox, oy, eye, -1, false, result),
+                Octants(map, ox, oy, eye, +1, true, result),
+                Octants(map, ox, oy, eye, -1, true, result),
+        };
+        tbb::parallel_for(0, 4, [&groups](int g) {
+            tbb::parallel_for(tbb::blocked_range<int>(0, groups[g].numRays(), RAY_GRAIN),
+                              [&groups, g](const tbb::blocked_range<int> &r) {
+                                  for (int i = r.begin(); i != r.end(); ++i) {
+                                      groups[g].castRay(i);
+                                  }
+                              });
+        });
+        return result;
+    }
+
+    //灰度图像 -> 高程图：高度 = 亮度 * scale
+    inline Heightmap fromImage(ImageLib::Image &image, double scale, double cell_size = 1.0) {
+        Heightmap map(image.width(), image.height(), cell_size);
+        auto &rows = image.rows();
+        tbb::parallel_for(0, map.height, [&](int y) {
+            for (int x = 0; x < map.width; ++x) {
+                const auto &p = rows[y][x];
+                map.at(x, y) = (float) ((0.11 * p.bgra[0] + 0.59 * p.bgra[1] + 0.3 * p.bgra[2]) * scale);
+            }
+        });
+        return map;
+    }
+
+    //高程图 -> 灰度图像，按最低/最高点拉伸到0..255
+    inline std::shared_ptr<ImageLib::Image> toImage(const Heightmap &map, const std::string &name) {
+        auto image = std::make_shared<ImageLib::Image>(name, map.width, map.height);
+        auto [lo, hi] = std::minmax_element(map.z.begin(), map.z.end());
+        const double range = std::max(1e-9, (double) (*hi - *lo));
+        auto &rows = image->rows();
+        tbb::parallel_for(0, map.height, [&](int y) {
+            for (int x = 0; x < map.width; ++x) {
+                int v = (int) ((map.at(x, y) - *lo) / range * ImageLib::MAX_BGR_VALUE);
+                rows[y][x] = ImageLib::Image::Pixel(v, v, v);
+            }
+        });
+        return image;
+    }
+
+    //可见性掩码图像：地形灰度作底，可见的格子染成绿色，观察点红色
+    inline std::shared_ptr<ImageLib::Image> maskImage(const Heightmap &map, const Result &result, int ox, int oy,
+                                                      const std::string &name) {
+        auto image = toImage(map, name);
+        auto &rows = image->rows();
+        tbb::parallel_for(0, map.height, [&](int y) {
+            for (int x = 0; x < map.width; ++x) {
+                if (result.at(x, y)) {
+                    const int v = rows[y][x].bgra[0];
+                    rows[y][x] = ImageLib::Image::Pixel(v / 2, 128 + v / 2, v / 2);
+                }
+            }
+        });
+        if (ox >= 0 && oy >= 0 && ox < map.width && oy < map.height) {
+            rows[oy][ox] = ImageLib::Image::Pixel(0, 0, 255);
+        }
+        return image;
+    }
+
+}
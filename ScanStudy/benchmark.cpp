@@ -0,0 +1,117 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <tbb/tbb.h>
+#include "ParallelScan.h"
+#include "SegmentedScan.h"
+#include "Compaction.h"
+
+//前缀扫描基准测试
+//用法：ScanBenchmark [最大元素个数，默认1e8]
+//元素个数从1e6开始每次乘10（1e9个int需要8GB：输入+输出），
+//比较main.cpp中原来的parallelPrefix（tbb::parallel_scan + 标量循环）和Scan模块的各个版本
+
+//原来的实现：tbb::parallel_scan，两趟，块内是标量的sum += v[i]
+template <typename T>
+T tbbParallelScan(const T *v, T *psum, std::size_t n){
+    return tbb::parallel_scan(
+            tbb::blocked_range<std::size_t>(0, n),
+            T(0),
+            [v, psum](const tbb::blocked_range<std::size_t> &r, T sum, bool is_final_scan) -> T{
+                for(std::size_t i = r.begin(); i < r.end(); ++i){
+                    sum += v[i];
+                    if(is_final_scan){
+                        psum[i] = sum;
+                    }
+                }
+                return sum;
+            },
+            [](T x, T y){
+                return x + y;
+            }
+    );
+}
+
+//重复3次取最快
+template <typename F>
+double bestOf3(F f){
+    double best = 1e300;
+    for(int rep = 0; rep < 3; ++rep){
+        tbb::tick_count t0 = tbb::tick_count::now();
+        f();
+        best = std::min(best, (tbb::tick_count::now() - t0).seconds());
+    }
+    return best;
+}
+
+template <typename T>
+void benchmarkType(const char *type_name, std::size_t max_n){
+    for(std::size_t n = 1000000; n <= max_n; n *= 10){
+        std::vector<T> in(n), out(n);
+        tbb::parallel_for(std::size_t(0), n, [&in](std::size_t i){
+            in[i] = T(i % 7);
+        });
+        auto report = [&](const char *name, double time){
+            std::cout << std::setw(8) << type_name << std::setw(12) << (double)n
+                      << std::setw(26) << name << std::setw(12) << time << " s"
+                      << std::setw(10) << (int)(n / time / 1e6) << " Melem/s" << std::endl;
+        };
+        report("serial scalar", bestOf3([&]{
+            Scan::scalarChunkScan<false>(in.data(), out.data(), n, T(0), Scan::Sum<T>());
+        }));
+        report("parallelPrefix (tbb)", bestOf3([&]{ tbbParallelScan(in.data(), out.data(), n); }));
+        report("Scan::serialScan", bestOf3([&]{ Scan::serialScan(in.data(), out.data(), n); }));
+        report("Scan::parallelScan", bestOf3([&]{ Scan::parallelScan(in.data(), out.data(), n); }));
+        report("Scan::singlePassScan", bestOf3([&]{ Scan::singlePassScan(in.data(), out.data(), n); }));
+        //就地扫描会改变输入，每次重新初始化不计时太麻烦，直接在扫描结果上继续扫描（耗时相同）
+        report("singlePassScan in-place", bestOf3([&]{ Scan::singlePassScan(out.data(), out.data(), n); }));
+    }
+}
+
+//分段扫描和压缩：一半的元素被保留，平均每64个元素一段
+void benchmarkCompaction(std::size_t max_n){
+    for(std::size_t n = 1000000; n <= max_n; n *= 10){
+        std::vector<std::int32_t> in(n), out(n);
+        std::vector<std::uint8_t> flags(n);
+        tbb::parallel_for(std::size_t(0), n, [&](std::size_t i){
+            std::uint32_t h = (std::uint32_t)i * 2654435761u;
+            in[i] = (std::int32_t)(h >> 8);
+            flags[i] = (h >> 26) == 0;
+        });
+        flags[0] = 1;
+        auto pred = [](std::int32_t x){ return (x & 1) == 0; };
+        auto report = [&](const char *name, double time){
+            std::cout << std::setw(12) << (double)n << std::setw(28) << name << std::setw(12) << time << " s"
+                      << std::setw(10) << (int)(n / time / 1e6) << " Melem/s" << std::endl;
+        };
+        report("serial segmented scan", bestOf3([&]{
+            std::int32_t acc = 0;
+            for(std::size_t i = 0; i < n; ++i){
+                acc = flags[i] ? in[i] : acc + in[i];
+                out[i] = acc;
+            }
+        }));
+        report("Scan::segmentedScan", bestOf3([&]{ Scan::segmentedScan(in.data(), out.data(), n, flags.data()); }));
+        report("std::copy_if", bestOf3([&]{ std::copy_if(in.begin(), in.end(), out.begin(), pred); }));
+        report("Compaction::copyIf", bestOf3([&]{ Compaction::copyIf(in.data(), out.data(), n, pred); }));
+        report("serial partition copy", bestOf3([&]{
+            auto mid = std::copy_if(in.begin(), in.end(), out.begin(), pred);
+            std::remove_copy_if(in.begin(), in.end(), mid, pred);
+        }));
+        report("Compaction::partitionCopy", bestOf3([&]{ Compaction::partitionCopy(in.data(), out.data(), n, pred); }));
+    }
+}
+
+int main(int argc, char **argv){
+    const std::size_t max_n = argc > 1 ? (std::size_t)std::atof(argv[1]) : 100000000;
+    std::cout << "threads: " << tbb::info::default_concurrency() << std::endl;
+    benchmarkType<std::int32_t>("int32", max_n);
+    benchmarkType<float>("float", max_n);
+    benchmarkType<double>("double", max_n);
+    benchmarkCompaction(max_n);
+    return 0;
+}
@@ -1,6 +1,15 @@
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstdlib>
 #include <tbb/tbb.h>
+#include "ParallelScan.h"
+#include "SegmentedScan.h"
+#include "Compaction.h"
+#include "LineOfSight.h"
+#include "Viewshed.h"
 
 //串行前缀和
 int normalPrefix(const std::vector<int> &v, std::vector<int> &psum){
@@ -36,32 +45,282 @@ int parallelPrefix(const std::vector<int> &v, std::vector<int> &psum){
 }
 
 //薄板可见性
-void visibility(const std::vector<double> &heights, std::vector<bool> & visible, double dx){
-    const int N = heights.size();
-    double max_angle = std::atan2(dx, heights[0] - heights[1]);
+//原来的版本写std::vector<bool>，并行扫描的相邻块会写同一个字，有数据竞争；每个点还要算一次atan2
+//现在用LineOfSight：比较坡度，按整字写位图
+void visibility(const std::vector<double> &heights, LineOfSight::VisibilityBits &visible, double dx){
+    LineOfSight::profileVisibility(heights.data(), heights.size(), dx, visible);
+}
 
-    double final_max_angle = tbb::parallel_scan(
-            tbb::blocked_range<int>(1, N),
-            0.0,
-            [&heights, &visible, dx](const tbb::blocked_range<int> &r, double max_angle, bool is_final_scan) -> double {
-                for(int i = r.begin(); i != r.end(); ++i){
-                    double my_angle = atan2(i * dx, heights[0] - heights[i]);
-                    if(my_angle >= max_angle){
-                        max_angle = my_angle;
-                    }
-                    else if(is_final_scan){
-                        visible[i] = false;
-                    }
+//大剖面：与串行的atan2版本比较结果和耗时
+void testLineOfSight(){
+    //不是64的整数倍，最后一个字不满
+    const std::size_t N = (1 << 24) + 37;
+    const double dx = 1.0;
+    //坡度越来越陡的山脊（高度~i^2），每97个点有一个凹陷，凹陷长度1~40个点（观察点不在凹陷里）：
+    //凹陷里的点不可见，凹陷之后山脊的坡度超过凹陷前的最大坡度，又变成可见；
+    //可见/不可见的交替大量落在字中间和跨越字（扫描块）的边界上
+    std::vector<double> heights(N);
+    for(std::size_t i = 0; i < N; ++i){
+        const double rise = 1e-6 * (double)i * i;
+        heights[i] = 1000 + rise;
+        if(i > 0 && i % 97 < 1 + (i / 97) % 40){
+            //凹陷深度随山脊升高按比例加深，远处的凹陷也整段不可见
+            heights[i] -= 50 + 0.05 * rise;
+        }
+    }
+
+    tbb::tick_count t0 = tbb::tick_count::now();
+    std::vector<std::uint8_t> gold(N, 1);
+    double max_angle = 0;
+    for(std::size_t i = 1; i < N; ++i){
+        double angle = std::atan2(i * dx, heights[0] - heights[i]);
+        if(angle >= max_angle){
+            max_angle = angle;
+        }
+        else{
+            gold[i] = 0;
+        }
+    }
+    double serial_time = (tbb::tick_count::now() - t0).seconds();
+
+    LineOfSight::VisibilityBits visible;
+    t0 = tbb::tick_count::now();
+    visibility(heights, visible, dx);
+    double parallel_time = (tbb::tick_count::now() - t0).seconds();
+
+    std::size_t mismatches = 0, boundary_changes = 0;
+    for(std::size_t i = 0; i < N; ++i){
+        mismatches += visible.test(i) != (gold[i] != 0);
+        //可见性在字边界两侧不同
+        if(i > 0 && i % LineOfSight::WORD_BITS == 0){
+            boundary_changes += visible.test(i - 1) != visible.test(i);
+        }
+    }
+    std::cout << "profile N=" << N << ": serial atan2 " << serial_time << " s, parallel slope " << parallel_time
+              << " s, visible " << visible.count() << ", changes at word boundaries " << boundary_changes
+              << ", mismatches " << mismatches << std::endl;
+    if(mismatches != 0 || visible.count() < N / 2 || visible.count() == N || boundary_changes < 1000){
+        std::cerr << "  line of sight failed" << std::endl;
+    }
+
+    //多个观察点 x 多条径向线
+    LineOfSight::Heightmap map(2048, 2048);
+    tbb::parallel_for(0, map.height, [&map](int y){
+        for(int x = 0; x < map.width; ++x){
+            map.at(x, y) = (float)(100 * std::sin(x * 0.01) * std::cos(y * 0.013) + 30 * std::sin((x + y) * 0.05));
+        }
+    });
+    std::vector<LineOfSight::Observer> observers;
+    for(int k = 0; k < 16; ++k){
+        observers.push_back({128.0 + 112 * k, 1024.0 + 600 * std::sin(k), 10.0});
+    }
+    t0 = tbb::tick_count::now();
+    auto radial = LineOfSight::radialLines(map, observers, 4096);
+    double radial_time = (tbb::tick_count::now() - t0).seconds();
+    std::size_t samples = 0, seen = 0;
+    for(int o = 0; o < (int)observers.size(); ++o){
+        for(int r = 0; r < radial.numRays(); ++r){
+            samples += radial.samples(o, r);
+            for(int k = 0; k < radial.samples(o, r); ++k){
+                seen += radial.visible(o, r, k);
+            }
+        }
+    }
+    std::cout << observers.size() << " observers x " << radial.numRays() << " rays: " << radial_time << " s, "
+              << samples << " samples, " << seen << " visible" << std::endl;
+}
+
+//合成地形：几组正弦叠加成的山脊和山谷
+LineOfSight::Heightmap makeTerrain(int width, int height){
+    LineOfSight::Heightmap map(width, height);
+    tbb::parallel_for(0, height, [&map, width](int y){
+        for(int x = 0; x < width; ++x){
+            double h = 60 * std::sin(x * 0.011) * std::cos(y * 0.017) + 25 * std::sin((x + 2 * y) * 0.031)
+                       + 10 * std::cos((3 * x - y) * 0.05);
+            map.at(x, y) = (float)(h + 100);
+        }
+    });
+    return map;
+}
+
+//逐格的参考结果：从观察点到格心直接采样（步长0.25格，双线性插值），检查路上的最大坡度
+bool referenceVisible(const LineOfSight::Heightmap &map, int ox, int oy, double eye, int x, int y){
+    const double dist = std::hypot(x - ox, y - oy);
+    if(dist == 0){
+        return true;
+    }
+    const LineOfSight::Slope target{map.at(x, y) - eye, dist * map.cell_size};
+    const int steps = (int)(dist * 4);
+    for(int k = 1; k < steps; ++k){
+        const double f = (double)k / steps;
+        const LineOfSight::Slope s{map.sample(ox + (x - ox) * f, oy + (y - oy) * f) - eye, dist * f * map.cell_size};
+        if(!LineOfSight::notBelow(target, s)){
+            return false;
+        }
+    }
+    return true;
+}
+
+//二维视域：高程图导出成图像再读回，计算视域，写出掩码图像；小图上与逐格参考结果比较
+void testViewshed(const char *heightmap_file, int ox, int oy){
+    LineOfSight::Heightmap map;
+    if(heightmap_file){
+        ImageLib::Image image("heightmap");
+        if(!image.read(heightmap_file)){
+            return;
+        }
+        map = Viewshed::fromImage(image, 1.0);
+    }
+    else{
+        map = makeTerrain(4096, 4096);
+        Viewshed::toImage(map, "heightmap")->write("heightmap.bmp");
+        ImageLib::Image image("heightmap");
+        image.read("heightmap.bmp");
+        map = Viewshed::fromImage(image, 1.0);
+    }
+    if(ox < 0){
+        ox = map.width / 3, oy = map.height / 2;
+    }
+    const double eye_height = 5.0;
+    tbb::tick_count t0 = tbb::tick_count::now();
+    Viewshed::Result result = Viewshed::compute(map, ox, oy, eye_height);
+    double time = (tbb::tick_count::now() - t0).seconds();
+    std::cout << "viewshed " << map.width << "x" << map.height << " from (" << ox << "," << oy << "): " << time
+              << " s, " << result.count() << " visible cells" << std::endl;
+    Viewshed::maskImage(map, result, ox, oy, "viewshed")->write("viewshed.bmp");
+
+    LineOfSight::Heightmap small = makeTerrain(256, 256);
+    const int sx = 90, sy = 130;
+    Viewshed::Result small_result = Viewshed::compute(small, sx, sy, eye_height);
+    const double eye = small.at(sx, sy) + eye_height;
+    std::size_t agree = 0;
+    for(int y = 0; y < small.height; ++y){
+        for(int x = 0; x < small.width; ++x){
+            agree += small_result.at(x, y) == referenceVisible(small, sx, sy, eye, x, y);
+        }
+    }
+    //不一致来自两处舍入，只影响坡度和地平线几乎相等的格子（可见性边界、掠射的坡面）：
+    //- 格子归副轴坐标最近的射线，地平线沿这条射线算，射线离格心最多半个射线间距
+    //- 地平线用该列（行）相邻两格的线性插值，参考结果用双线性插值、0.25格步长
+    //这个地形和观察点上约0.76%的格子不一致（结果与线程数无关），超过1%说明算法出了问题
+    const double agreement = (double)agree / ((double)small.width * small.height);
+    const double min_agreement = 0.99;
+    std::cout << "Viewshed tests " << (agreement >= min_agreement ? "passed" : "FAILED")
+              << ", agreement with per-cell reference " << 100.0 * agreement << "% (at least "
+              << 100.0 * min_agreement << "%)" << std::endl;
+}
+
+//Scan模块的正确性：各种规模、运算、包含/排除式、就地，与串行标量扫描比较
+template <bool Exclusive, typename T, typename Op>
+bool checkScan(const std::vector<T> &v, Op op, const char *name){
+    const std::size_t N = v.size();
+    std::vector<T> gold(N), out(N), inplace = v;
+    T gold_total = Scan::scalarChunkScan<Exclusive>(v.data(), gold.data(), N, Op::identity(), op);
+    //浮点求和的SIMD和分块改变了加法顺序，按相对误差比较
+    auto same = [](T a, T b){
+        return std::abs((double)a - (double)b) <= 1e-9 * std::max(1.0, std::abs((double)b));
+    };
+    bool ok = true;
+    auto check = [&](const char *mode, const std::vector<T> &res, T total){
+        bool good = same(total, gold_total);
+        for(std::size_t i = 0; i < N && good; ++i){
+            good = same(res[i], gold[i]);
+        }
+        if(!good){
+            std::cerr << "  " << name << (Exclusive ? " exclusive " : " inclusive ") << mode << " N=" << N << " failed" << std::endl;
+            ok = false;
+        }
+    };
+    check("serialScan", out, Scan::serialScan<Exclusive>(v.data(), out.data(), N, op));
+    check("parallelScan", out, Scan::parallelScan<Exclusive>(v.data(), out.data(), N, op));
+    check("singlePassScan", out, Scan::singlePassScan<Exclusive>(v.data(), out.data(), N, op));
+    check("singlePassScan in-place", inplace, Scan::singlePassScan<Exclusive>(inplace.data(), inplace.data(), N, op));
+    inplace = v;
+    check("parallelScan in-place", inplace, Scan::parallelScan<Exclusive>(inplace.data(), inplace.data(), N, op));
+    return ok;
+}
+
+void testScan(){
+    std::mt19937 rng(2023);
+    bool ok = true;
+    for(std::size_t N : {0, 1, 3, 1000, 32768, 100003, 1 << 20, 3000017}){
+        std::vector<int> vi(N);
+        std::vector<double> vd(N);
+        for(std::size_t i = 0; i < N; ++i){
+            vi[i] = (int)(rng() % 201) - 100;
+            vd[i] = (double)(rng() % 1000) / 7.0;
+        }
+        ok &= checkScan<false>(vi, Scan::Sum<int>(), "sum<int>");
+        ok &= checkScan<true>(vi, Scan::Sum<int>(), "sum<int>");
+        ok &= checkScan<false>(vi, Scan::Max<int>(), "max<int>");
+        ok &= checkScan<true>(vi, Scan::Min<int>(), "min<int>");
+        ok &= checkScan<false>(vd, Scan::Sum<double>(), "sum<double>");
+    }
+    std::cout << "Scan tests " << (ok ? "passed" : "FAILED") << std::endl;
+}
+
+//分段扫描和压缩的正确性，与串行实现比较
+void testSegmentedAndCompaction(){
+    std::mt19937 rng(7);
+    bool ok = true;
+    for(std::size_t N : {0, 5, 1000, 100003, 3000017}){
+        std::vector<int> v(N);
+        std::vector<std::uint8_t> flags(N);
+        std::vector<std::size_t> offsets;
+        for(std::size_t i = 0; i < N; ++i){
+            v[i] = (int)(rng() % 201) - 100;
+            //段长差别很大：大部分段很短，偶尔有跨越多个块的长段
+            flags[i] = (i == 0 || rng() % (i < N / 2 ? 16 : 200000) == 0);
+            if(flags[i]){
+                offsets.push_back(i);
+                //偶尔插入一个空段
+                if(rng() % 8 == 0){
+                    offsets.push_back(i);
                 }
-                return max_angle;
-            },
-            [](double a, double b){
-                return std::max(a, b);
             }
-        );
+        }
+        std::vector<int> gold(N), gold_ex(N), out(N), inplace = v;
+        int acc = 0;
+        for(std::size_t i = 0; i < N; ++i){
+            if(flags[i]){
+                acc = 0;
+            }
+            gold_ex[i] = acc;
+            acc += v[i];
+            gold[i] = acc;
+        }
+        Scan::segmentedScan(v.data(), out.data(), N, flags.data());
+        ok &= out == gold;
+        Scan::segmentedScan<true>(v.data(), out.data(), N, flags.data());
+        ok &= out == gold_ex;
+        Scan::segmentedScan(inplace.data(), inplace.data(), N, offsets.data(), offsets.size());
+        ok &= inplace == gold;
+
+        auto pred = [](int x){ return x % 3 == 0; };
+        std::vector<int> expected, selected(N), part(N), expected_part(N);
+        std::copy_if(v.begin(), v.end(), std::back_inserter(expected), pred);
+        std::size_t count = Compaction::copyIf(v.data(), selected.data(), N, pred);
+        selected.resize(count);
+        ok &= selected == expected;
+
+        std::vector<std::uint32_t> idx(N);
+        count = Compaction::selectIndices(N, idx.data(), [&](std::size_t i){ return pred(v[i]); });
+        std::vector<int> gathered(count);
+        Compaction::gather(v.data(), idx.data(), count, gathered.data());
+        ok &= gathered == expected;
+
+        auto split = std::stable_partition(expected_part.begin(), std::copy(v.begin(), v.end(), expected_part.begin()), pred);
+        ok &= Compaction::partitionCopy(v.data(), part.data(), N, pred) == (std::size_t)(split - expected_part.begin());
+        ok &= part == expected_part;
+        if(!ok){
+            std::cerr << "  segmented scan / compaction failed at N=" << N << std::endl;
+            break;
+        }
+    }
+    std::cout << "Segmented scan / compaction tests " << (ok ? "passed" : "FAILED") << std::endl;
 }
 
-int main(){
+int main(int argc, char **argv){
     std::vector<int> a;
     for(int i = 0; i < 10; ++i){
         a.push_back(i);
@@ -69,11 +328,16 @@ int main(){
     std::vector<int> ans = a;
     std::cout << parallelPrefix(a, ans) << std::endl;
     std::vector<double> height = {10, 3, 6, 4, 9, 1, 9.9};
-    std::vector<bool> vis(height.size(), true);
+    LineOfSight::VisibilityBits vis;
     visibility(height, vis, 1);
-    for(auto i : vis){
-        std::cout << i << " ";
+    for(std::size_t i = 0; i < vis.size(); ++i){
+        std::cout << vis.test(i) << " ";
     }
     std::cout << std::endl;
+    testLineOfSight();
+    //ScanStudy [高程图.bmp] [观察点x y]
+    testViewshed(argc > 1 ? argv[1] : nullptr, argc > 3 ? std::atoi(argv[2]) : -1, argc > 3 ? std::atoi(argv[3]) : -1);
+    testScan();
+    testSegmentedAndCompaction();
     return 0;
 }
\ No newline at end of file
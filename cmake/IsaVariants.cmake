@@ -0,0 +1,58 @@
+include_guard(GLOBAL)
+
+# 热点kernel的ISA版本：打开后kernel源文件按SSE4.2、AVX2、AVX-512各多编译一份，运行时按CPU选择
+option(SAMPLES_ISA_VARIANTS "Compile SSE4.2/AVX2/AVX-512 kernel variants with runtime dispatch" OFF)
+
+include(CheckCXXCompilerFlag)
+
+# 各版本的地址放在Dispatch的Kernel<Fn>里，单独构建示例时也要有这个目标
+if(NOT TARGET Dispatch)
+    add_subdirectory(${CMAKE_CURRENT_LIST_DIR}/../Dispatch ${CMAKE_BINARY_DIR}/Dispatch)
+endif()
+
+# sample_isa_variants(<target> SOURCES <kernel源文件>... [LIBRARIES <依赖>...])
+# - kernel源文件包含DispatchVariant.h，kernel函数定义在SAMPLES_ISA_NS里，用SAMPLES_KERNEL定义访问函数
+# - target本身编译一份默认版本（SAMPLES_ISA_NS未定义，取scalar），Kernel对象只在这一份里构造
+# - SAMPLES_ISA_VARIANTS打开且是x86时，每个ISA一个OBJECT库，定义SAMPLES_ISA_NS=<isa>和SAMPLES_ISA_LEVEL，
+#   目标文件链接进target，target定义SAMPLES_ISA_HAVE_<ISA>；同一个target可以调用多次
+# - 各版本都用-ffp-contract=off，不把乘加合并成FMA，结果和scalar版本逐位相同
+function(sample_isa_variants target)
+    cmake_parse_arguments(ARG "" "" "SOURCES;LIBRARIES" ${ARGN})
+    target_sources(${target} PRIVATE ${ARG_SOURCES})
+    target_link_libraries(${target} Dispatch)
+    if(NOT SAMPLES_ISA_VARIANTS)
+        return()
+    endif()
+    if(MSVC OR NOT CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64|amd64|i.86")
+        message(STATUS "${target}: ISA variants need GCC/Clang on x86, building the scalar kernels only")
+        return()
+    endif()
+
+    # 和Dispatch::Isa的值一致
+    set(level_sse42 1)
+    set(level_avx2 2)
+    set(level_avx512 3)
+    set(flags_sse42 -msse4.2 -mpopcnt)
+    set(flags_avx2 -mavx2 -mfma -mbmi2)
+    set(flags_avx512 -mavx512f -mavx512bw -mavx512vl -mavx512dq -mfma -mbmi2)
+    check_cxx_compiler_flag("-mavx512f -mavx512bw -mavx512vl -mavx512dq" SAMPLES_HAVE_AVX512_FLAGS)
+
+    set(isas sse42 avx2)
+    if(SAMPLES_HAVE_AVX512_FLAGS)
+        list(APPEND isas avx512)
+    endif()
+    foreach(isa IN LISTS isas)
+        string(TOUPPER ${isa} isa_upper)
+        target_compile_definitions(${target} PRIVATE SAMPLES_ISA_HAVE_${isa_upper})
+        if(TARGET ${target}_${isa})
+            target_sources(${target}_${isa} PRIVATE ${ARG_SOURCES})
+            target_link_libraries(${target}_${isa} PRIVATE ${ARG_LIBRARIES})
+            continue()
+        endif()
+        add_library(${target}_${isa} OBJECT ${ARG_SOURCES})
+        target_compile_definitions(${target}_${isa} PRIVATE SAMPLES_ISA_NS=${isa} SAMPLES_ISA_LEVEL=${level_${isa}})
+        target_compile_options(${target}_${isa} PRIVATE ${flags_${isa}} -ffp-contract=off)
+        target_link_libraries(${target}_${isa} PRIVATE Dispatch ${ARG_LIBRARIES})
+        target_sources(${target} PRIVATE $<TARGET_OBJECTS:${target}_${isa}>)
+    endforeach()
+endfunction()
@@ -0,0 +1,63 @@
+include_guard(GLOBAL)
+
+# 构建配置
+# - CMAKE_BUILD_TYPE：Release（默认，-O3）、RelWithDebInfo（-O3 -g，保留帧指针，方便perf/VTune）、Debug
+# - SAMPLES_NATIVE：-march=native，只在本机运行时用；要分发的程序用SAMPLES_ISA_VARIANTS
+# - SAMPLES_LTO：链接时优化
+# - SAMPLES_PGO：OFF、GENERATE（插桩，运行后在SAMPLES_PGO_DIR里留下profile）、USE（用profile重新编译，默认同时打开LTO）
+if(NOT CMAKE_BUILD_TYPE AND NOT CMAKE_CONFIGURATION_TYPES)
+    set(CMAKE_BUILD_TYPE Release CACHE STRING "Build type" FORCE)
+endif()
+set_property(CACHE CMAKE_BUILD_TYPE PROPERTY STRINGS Debug Release RelWithDebInfo)
+
+option(SAMPLES_NATIVE "Tune for the build machine (-march=native)" OFF)
+option(SAMPLES_LTO "Enable link-time optimization" OFF)
+set(SAMPLES_PGO OFF CACHE STRING "Profile-guided optimization stage: OFF, GENERATE or USE")
+set_property(CACHE SAMPLES_PGO PROPERTY STRINGS OFF GENERATE USE)
+set(SAMPLES_PGO_DIR "${CMAKE_BINARY_DIR}/pgo-profiles" CACHE PATH "Directory of the PGO profiles")
+
+if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+    set(CMAKE_CXX_FLAGS_RELEASE "-O3 -DNDEBUG")
+    set(CMAKE_CXX_FLAGS_RELWITHDEBINFO "-O3 -g -fno-omit-frame-pointer -DNDEBUG")
+    if(SAMPLES_NATIVE)
+        add_compile_options(-march=native)
+    endif()
+endif()
+
+if(SAMPLES_PGO STREQUAL "GENERATE")
+    file(MAKE_DIRECTORY ${SAMPLES_PGO_DIR})
+    if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+        # 多线程的计数用原子操作，否则并行的热点循环计数会丢
+        # profile文件名里去掉构建目录，GENERATE和USE可以用不同的构建目录
+        set(pgo_flags -fprofile-generate=${SAMPLES_PGO_DIR} -fprofile-prefix-path=${CMAKE_BINARY_DIR}
+                      -fprofile-update=prefer-atomic)
+    elseif(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        set(pgo_flags -fprofile-instr-generate=${SAMPLES_PGO_DIR}/%m-%p.profraw)
+    endif()
+elseif(SAMPLES_PGO STREQUAL "USE")
+    if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+        # 没有被训练覆盖到的文件照常优化；多线程的计数可能不一致，允许修正
+        set(pgo_flags -fprofile-use=${SAMPLES_PGO_DIR} -fprofile-prefix-path=${CMAKE_BINARY_DIR}
+                      -fprofile-partial-training -fprofile-correction -Wno-missing-profile)
+    elseif(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        # Clang的.profraw要先用llvm-profdata merge成samples.profdata
+        set(pgo_flags -fprofile-instr-use=${SAMPLES_PGO_DIR}/samples.profdata -Wno-profile-instr-unprofiled)
+    endif()
+    set(SAMPLES_LTO ON)
+elseif(NOT SAMPLES_PGO STREQUAL "OFF")
+    message(FATAL_ERROR "SAMPLES_PGO must be OFF, GENERATE or USE, got '${SAMPLES_PGO}'")
+endif()
+if(pgo_flags)
+    add_compile_options(${pgo_flags})
+    add_link_options(${pgo_flags})
+endif()
+
+if(SAMPLES_LTO)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT lto_supported OUTPUT lto_error LANGUAGES CXX)
+    if(lto_supported)
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+    else()
+        message(WARNING "LTO is not supported: ${lto_error}")
+    endif()
+endif()